@@ -0,0 +1,93 @@
+#include <random>
+#include <string>
+#include <vector>
+#include <SweepAndPrune.hpp>
+#include <Scene.hpp>
+#include <Event.hpp>
+#include <components/Body.hpp>
+#include <systems/CollisionSystem.hpp>
+#include <catch.hpp>
+
+TEST_CASE("collision broad phase", "[collision][!benchmark]") {
+    // Asteroids drifting in a belt, each with a few convex components
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<float> radiusDistribution(5000.f, 8000.f);
+    std::uniform_real_distribution<float> angleDistribution(0.f, 2.f * pi);
+    std::uniform_real_distribution<float> sizeDistribution(5.f, 40.f);
+    std::uniform_real_distribution<float> moveDistribution(-2.f, 2.f);
+    for (std::size_t n : {500, 2000, 8000}) {
+        std::vector<SweepAndPrune::Box> boxes;
+        for (std::size_t i{0}; i < n; ++i) {
+            const float angle{angleDistribution(generator)};
+            const Vector2f center{radiusDistribution(generator) * Vector2f(std::cos(angle), std::sin(angle))};
+            const Vector2f extent{sizeDistribution(generator), sizeDistribution(generator)};
+            boxes.push_back({center - extent, center + extent});
+        }
+        SweepAndPrune broadPhase;
+        broadPhase.update(boxes);
+
+        BENCHMARK("Sweep and prune, " + std::to_string(n) + " boxes") {
+            for (SweepAndPrune::Box& box : boxes) {
+                const Vector2f move{moveDistribution(generator), moveDistribution(generator)};
+                box.min += move;
+                box.max += move;
+            }
+            broadPhase.update(boxes);
+            return broadPhase.getPairs().size();
+        };
+    }
+}
+
+TEST_CASE("collision narrow phase", "[collision][!benchmark]") {
+    // Isolated pairs of overlapping bodies, so that the benchmark measures
+    // GJK and EPA on each pair rather than the broad phase
+    Scene scene;
+    scene.registerComponent<Body>();
+    scene.registerComponent<CircleBody>();
+    scene.registerComponent<PolygonBody>();
+    scene.registerGroup<Body, CircleBody>();
+    scene.registerGroup<Body, PolygonBody>();
+    const std::vector<Vector2f> box{{0, 0}, {20, 0}, {20, 20}, {0, 20}};
+    const std::vector<Vector2f> hexagon{{0, 10}, {6, 0}, {16, 0}, {22, 10}, {16, 20}, {6, 20}};
+    const std::size_t pairs{100};
+    const auto createBody = [&scene](const Vector2f& position, float rotation) {
+        const EntityId id{scene.createEntity()};
+        Body body{};
+        body.density = 1;
+        body.position = position;
+        body.rotation = rotation;
+        body.restitution = 0.5f;
+        body.friction = 0.5f;
+        scene.assignComponent<Body>(id, body);
+        return id;
+    };
+    for (std::size_t i{0}; i < pairs; ++i) {
+        const Vector2f origin{static_cast<float>(i) * 100.f, 0.f};
+        for (const std::vector<Vector2f>* shape : {&box, &hexagon}) {
+            for (const Vector2f offset : {Vector2f(0, 0), Vector2f(19, 3)}) {
+                const EntityId id{createBody(origin + offset, 0.02f * offset.x)};
+                PolygonBody& polygon{scene.assignComponent<PolygonBody>(id)};
+                polygon = PolygonBody(scene.getComponent<Body>(id), *shape);
+            }
+        }
+        const EntityId id{createBody(origin + Vector2f(0, 30), 0)};
+        CircleBody& circle{scene.assignComponent<CircleBody>(id)};
+        circle = CircleBody(scene.getComponent<Body>(id), 12);
+    }
+    // Each update pushes the bodies apart, so they are put back before the
+    // next one
+    const ComponentStorage<Body>& bodies{scene.components<Body>()};
+    const std::vector<Vector2f> positions{bodies.positions};
+    const std::vector<Vector2f> velocities{bodies.velocities};
+    const std::vector<float> angularVelocities{bodies.angularVelocities};
+    CollisionSystem collisionSystem{scene};
+
+    BENCHMARK("GJK and EPA, " + std::to_string(pairs) + " groups of overlapping bodies") {
+        ComponentStorage<Body>& storage{scene.components<Body>()};
+        storage.positions = positions;
+        storage.velocities = velocities;
+        storage.angularVelocities = angularVelocities;
+        collisionSystem.update();
+        return collisionSystem.queueEvents().size();
+    };
+}
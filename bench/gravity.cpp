@@ -0,0 +1,82 @@
+#include <random>
+#include <vector>
+#include <string>
+#include <iostream>
+#include <iomanip>
+#include <BarnesHutTree.hpp>
+#include <catch.hpp>
+
+namespace {
+    // A star with an asteroid belt around it
+    void asteroidBelt(std::size_t n, std::vector<Vector2f>& positions, std::vector<float>& masses) {
+        std::mt19937 generator(42);
+        std::uniform_real_distribution<float> radiusDistribution(5000.f, 8000.f);
+        std::uniform_real_distribution<float> angleDistribution(0.f, 2.f * pi);
+        std::uniform_real_distribution<float> massDistribution(1.f, 100.f);
+        positions = {{0.f, 0.f}};
+        masses = {1e6f};
+        for (std::size_t i{1}; i < n; ++i) {
+            positions.push_back(radiusDistribution(generator) * Vector2f(
+                std::cos(angleDistribution(generator)), std::sin(angleDistribution(generator))));
+            masses.push_back(massDistribution(generator));
+        }
+    }
+
+    std::vector<Vector2f> directSum(const std::vector<Vector2f>& positions, const std::vector<float>& masses) {
+        std::vector<Vector2f> res(positions.size(), {0.f, 0.f});
+        for (std::size_t i{0}; i < positions.size(); ++i) {
+            for (std::size_t j{0}; j < positions.size(); ++j) {
+                if (j != i) {
+                    const Vector2f dx{positions[j] - positions[i]};
+                    const float dist{norm(dx)};
+                    res[i] += masses[j] * dx / (dist * dist * dist);
+                }
+            }
+        }
+        return res;
+    }
+
+    std::vector<Vector2f> barnesHut(BarnesHutTree& tree, const std::vector<Vector2f>& positions,
+            const std::vector<float>& masses, float theta) {
+        std::vector<Vector2f> res(positions.size());
+        tree.build(positions, masses, std::vector<float>(positions.size(), 0.f));
+        for (std::size_t i{0}; i < positions.size(); ++i) {
+            res[i] = tree.field(positions[i], i, theta);
+        }
+        return res;
+    }
+}
+
+TEST_CASE("gravity solvers", "[gravity][!benchmark]") {
+    const std::vector<float> thetas{0.3f, 0.5f, 0.7f, 1.f};
+    for (std::size_t n : {1000, 4000, 16000}) {
+        std::vector<Vector2f> positions;
+        std::vector<float> masses;
+        asteroidBelt(n, positions, masses);
+        BarnesHutTree tree;
+
+        // Accuracy of each opening angle, as the mean relative error of the
+        // accelerations
+        const std::vector<Vector2f> exact{directSum(positions, masses)};
+        for (float theta : thetas) {
+            const std::vector<Vector2f> approximation{barnesHut(tree, positions, masses, theta)};
+            float error{0};
+            for (std::size_t i{0}; i < n; ++i) {
+                error += norm(approximation[i] - exact[i]) / norm(exact[i]);
+            }
+            std::cout << "Barnes-Hut, " << n << " bodies, theta = " << theta
+                << ": mean relative error " << std::setprecision(3)
+                << error / static_cast<float>(n) << std::endl;
+        }
+
+        BENCHMARK("direct sum, " + std::to_string(n) + " bodies") {
+            return directSum(positions, masses);
+        };
+
+        for (float theta : thetas) {
+            BENCHMARK("Barnes-Hut, theta = " + std::to_string(theta).substr(0, 3) + ", " + std::to_string(n) + " bodies") {
+                return barnesHut(tree, positions, masses, theta);
+            };
+        }
+    }
+}
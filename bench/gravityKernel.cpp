@@ -0,0 +1,45 @@
+#include <chrono>
+#include <random>
+#include <vector>
+#include <iostream>
+#include <iomanip>
+#include <GravityKernel.hpp>
+#include <catch.hpp>
+
+TEST_CASE("gravity kernels", "[gravityKernel][!benchmark]") {
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<float> positionDistribution(-1000.f, 1000.f);
+    std::uniform_real_distribution<float> massDistribution(1.f, 100.f);
+
+    for (std::size_t n{64}; n <= 16384; n *= 4) {
+        std::vector<Vector2f> positions;
+        std::vector<float> masses;
+        const std::vector<float> softenings(n, 0.f);
+        for (std::size_t i{0}; i < n; ++i) {
+            positions.emplace_back(positionDistribution(generator), positionDistribution(generator));
+            masses.push_back(massDistribution(generator));
+        }
+
+        for (auto& [name, kernel] : availableGravityKernels()) {
+            // Repeat the all-pairs sum until the measure is long enough to be
+            // meaningful
+            using Clock = std::chrono::steady_clock;
+            const Clock::time_point start{Clock::now()};
+            Clock::duration elapsed{0};
+            std::size_t repetitions{0};
+            Vector2f checksum{0, 0};
+            while (elapsed < std::chrono::milliseconds(200)) {
+                for (std::size_t i{0}; i < n; ++i) {
+                    checksum += gravityField(kernel, positions, masses, softenings, positions[i], i);
+                }
+                ++repetitions;
+                elapsed = Clock::now() - start;
+            }
+            const double seconds{std::chrono::duration<double>(elapsed).count()};
+            const double interactions{static_cast<double>(repetitions * n * (n - 1))};
+            std::cout << name << " kernel, " << n << " bodies: " << std::setprecision(3)
+                << interactions / seconds << " interactions/s (checksum "
+                << (checksum.x + checksum.y) / static_cast<float>(repetitions) << ")" << std::endl;
+        }
+    }
+}
@@ -0,0 +1,141 @@
+#include <map>
+#include <random>
+#include <numeric>
+#include <algorithm>
+#include <string>
+#include <Scene.hpp>
+#include <catch.hpp>
+
+namespace {
+    struct Position {
+        float x, y;
+    };
+
+    struct Velocity {
+        float x, y;
+    };
+
+    // Copy of the component array that Scene used before the sparse set, to
+    // compare the two storages.
+    template <typename T>
+    class MapArrayModel {
+    public:
+        T& assign(EntityId id, const T& value) {
+            mapping.emplace(id, components.size());
+            return components.emplace_back(value);
+        }
+
+        T& get(EntityId id) {
+            return components[mapping.at(id)];
+        }
+
+        void erase(EntityId id) {
+            std::size_t index{mapping.at(id)};
+            for (auto& [otherId, otherIndex] : mapping) {
+                if (otherIndex > index) {
+                    otherIndex--;
+                }
+            }
+            components.erase(components.begin() + static_cast<std::ptrdiff_t>(index));
+            mapping.erase(id);
+        }
+
+    private:
+        std::vector<T> components;
+        std::map<EntityId, std::size_t> mapping;
+    };
+
+    std::vector<EntityId> shuffledIds(std::size_t n) {
+        std::vector<EntityId> ids(n);
+        std::iota(ids.begin(), ids.end(), 0);
+        std::shuffle(ids.begin(), ids.end(), std::mt19937(42));
+        return ids;
+    }
+}
+
+TEST_CASE("component storage", "[scene][!benchmark]") {
+    for (std::size_t n : {1000, 10000, 100000}) {
+        const std::vector<EntityId> ids{shuffledIds(n)};
+        // Number of entities despawned and respawned in the churn benchmark
+        const std::size_t churn{std::min<std::size_t>(n, 1000)};
+
+        MapArrayModel<Position> mapModel;
+        Scene scene;
+        scene.registerComponent<Position>();
+        for (std::size_t i{0}; i < n; ++i) {
+            const EntityId id{scene.createEntity()};
+            scene.assignComponent<Position>(id, static_cast<float>(i), 0.f);
+            mapModel.assign(id, {static_cast<float>(i), 0.f});
+        }
+
+        BENCHMARK("map get, " + std::to_string(n) + " entities") {
+            float sum{0};
+            for (EntityId id : ids) {
+                sum += mapModel.get(id).x;
+            }
+            return sum;
+        };
+
+        BENCHMARK("sparse set get, " + std::to_string(n) + " entities") {
+            float sum{0};
+            for (EntityId id : ids) {
+                sum += scene.getComponent<Position>(id).x;
+            }
+            return sum;
+        };
+
+        BENCHMARK("map erase and assign, " + std::to_string(n) + " entities") {
+            for (std::size_t i{0}; i < churn; ++i) {
+                mapModel.erase(ids[i]);
+                mapModel.assign(ids[i], {0.f, 0.f});
+            }
+        };
+
+        BENCHMARK("sparse set erase and assign, " + std::to_string(n) + " entities") {
+            for (std::size_t i{0}; i < churn; ++i) {
+                scene.eraseComponent<Position>(ids[i]);
+                scene.assignComponent<Position>(ids[i], 0.f, 0.f);
+            }
+        };
+    }
+}
+
+TEST_CASE("view and group iteration", "[scene][!benchmark]") {
+    for (std::size_t n : {1000, 10000, 100000}) {
+        // Half of the entities have both components, in a shuffled order
+        Scene viewScene;
+        Scene groupScene;
+        for (Scene* scene : {&viewScene, &groupScene}) {
+            scene->registerComponent<Position>();
+            scene->registerComponent<Velocity>();
+        }
+        groupScene.registerGroup<Position, Velocity>();
+        const std::vector<EntityId> ids{shuffledIds(n)};
+        for (std::size_t i{0}; i < n; ++i) {
+            for (Scene* scene : {&viewScene, &groupScene}) {
+                const EntityId id{scene->createEntity()};
+                scene->assignComponent<Position>(id, static_cast<float>(i), 0.f);
+            }
+        }
+        for (std::size_t i{0}; i < n / 2; ++i) {
+            viewScene.assignComponent<Velocity>(ids[i], 1.f, 0.f);
+            groupScene.assignComponent<Velocity>(ids[i], 1.f, 0.f);
+        }
+
+        BENCHMARK("view, " + std::to_string(n) + " entities") {
+            float sum{0};
+            for (auto [id, position, velocity] : viewScene.view<Position, Velocity>()) {
+                sum += position.x * velocity.x;
+            }
+            return sum;
+        };
+
+        BENCHMARK("group, " + std::to_string(n) + " entities") {
+            float sum{0};
+            for (auto [id, position, velocity] : groupScene.group<Position, Velocity>()) {
+                sum += position.x * velocity.x;
+            }
+            return sum;
+        };
+    }
+}
@@ -0,0 +1,71 @@
+#ifndef BARNESHUTTREE_HPP
+#define BARNESHUTTREE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include <vector.hpp>
+
+// Quadtree approximating the gravitational field of point masses, with the
+// Barnes-Hut algorithm. Each node stores the total mass and the center of mass
+// of the bodies it contains, and a node seen under an angle smaller than theta
+// from the evaluation point is treated as a single point mass. Evaluating the
+// field is then O(log N) instead of O(N).
+class BarnesHutTree {
+public:
+    // Rebuilds the tree from the bodies. The memory of the previous build is
+    // reused, so this does not allocate once the tree reached its size.
+    // The softenings are the squared Plummer softening of each body, see
+    // GravityKernel.
+    void build(const std::vector<Vector2f>& positions, const std::vector<float>& masses,
+        const std::vector<float>& softenings);
+
+    // Returns the sum of m * (x - position) / (|x - position|^2 + e^2)^(3/2)
+    // over the bodies given to build, that is the acceleration without the
+    // gravitational constant. A node uses the mean softening of its bodies,
+    // weighted by their mass. The body at index exclude is ignored. A larger theta opens
+    // less nodes, so it is faster but less accurate, and theta = 0 gives the
+    // exact sum. This does not allocate.
+    Vector2f field(const Vector2f& position, std::size_t exclude, float theta) const;
+
+private:
+    static constexpr std::uint32_t none{std::numeric_limits<std::uint32_t>::max()};
+    // Bodies closer than the size of the root divided by 2^maxDepth end up in
+    // the same leaf, so that coincident bodies do not subdivide forever.
+    static constexpr unsigned maxDepth{32};
+
+    struct Node {
+        // Center and half of the side of the square covered by the node
+        Vector2f center;
+        float halfSize;
+        float mass{0};
+        Vector2f centerOfMass{0, 0};
+        float softening{0};
+        // Distance between the center of mass and the center
+        float offset{0};
+        // The four children are contiguous, none for a leaf
+        std::uint32_t firstChild{none};
+        // Body in a leaf, none for an empty leaf or an internal node
+        std::uint32_t body{none};
+    };
+
+    struct BodyEntry {
+        Vector2f position;
+        float mass;
+        float softening;
+        // Leaf containing the body
+        std::uint32_t leaf;
+    };
+
+    // Nodes in creation order, so children are always after their parent
+    std::vector<Node> _nodes;
+    std::vector<BodyEntry> _bodies;
+
+    void insert(std::uint32_t body);
+    void placeInLeaf(std::uint32_t node, std::uint32_t body);
+    void subdivide(std::uint32_t node);
+    std::uint32_t childContaining(std::uint32_t node, const Vector2f& position) const;
+};
+
+#endif // BARNESHUTTREE_HPP
@@ -0,0 +1,33 @@
+#ifndef GRAVITYKERNEL_HPP
+#define GRAVITYKERNEL_HPP
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+#include <vector.hpp>
+
+// A gravity kernel returns the sum of m * (x - position) / (|x - position|^2
+// + e^2)^(3/2) over count packed sources, that is the acceleration without the
+// gravitational constant. e^2 is the squared Plummer softening of each source,
+// which bounds its field near its center, zero giving a point mass. The
+// vectorized kernels evaluate the inverse distance with the approximate
+// reciprocal square root of the CPU, refined with one Newton step, so they
+// differ from the scalar kernel by a few ulps.
+typedef Vector2f (*GravityKernel)(const Vector2f* positions, const float* masses,
+    const float* softenings, std::size_t count, const Vector2f& position);
+
+// Kernels supported by the running CPU, from the slowest to the fastest. The
+// scalar kernel is always available.
+std::vector<std::pair<std::string, GravityKernel>> availableGravityKernels();
+
+// Fastest kernel supported by the running CPU
+GravityKernel bestGravityKernel();
+
+// Sums the field of all the sources but the one at index exclude, which may be
+// out of range to sum all of them.
+Vector2f gravityField(GravityKernel kernel, const std::vector<Vector2f>& positions,
+    const std::vector<float>& masses, const std::vector<float>& softenings,
+    const Vector2f& position, std::size_t exclude);
+
+#endif // GRAVITYKERNEL_HPP
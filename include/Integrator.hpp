@@ -0,0 +1,37 @@
+#ifndef INTEGRATOR_HPP
+#define INTEGRATOR_HPP
+
+#include <functional>
+#include <memory>
+#include <vector>
+#include <vector.hpp>
+
+enum class IntegratorType {
+    // Drift-kick-drift leapfrog, second order, one force evaluation per step
+    Leapfrog,
+    // Yoshida's fourth order composition of three leapfrog steps, three force
+    // evaluations per step
+    Yoshida4,
+    // Classical Runge-Kutta, fourth order, four force evaluations per step
+    RungeKutta4
+};
+
+// Advances the whole system at once, every stage seeing all the bodies at the
+// same intermediate time. The state is the packed positions and velocities of
+// the bodies, in the same order as the accelerations.
+class Integrator {
+public:
+    // Fills the accelerations of all the bodies at the given positions
+    typedef std::function<void(const std::vector<Vector2f>& positions,
+        std::vector<Vector2f>& accelerations)> AccelerationFunction;
+
+    virtual ~Integrator() = default;
+
+    // Advances the state by dt, which is negative to go back in time
+    virtual void step(std::vector<Vector2f>& positions, std::vector<Vector2f>& velocities,
+        float dt, const AccelerationFunction& acceleration) = 0;
+};
+
+std::unique_ptr<Integrator> createIntegrator(IntegratorType type);
+
+#endif // INTEGRATOR_HPP
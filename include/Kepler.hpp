@@ -0,0 +1,17 @@
+#ifndef KEPLER_HPP
+#define KEPLER_HPP
+
+#include <vector.hpp>
+
+// Advances the relative position and velocity of a body around its primary by
+// dt, on the conic they define. mu is the gravitational constant times the sum
+// of the two masses. This solves Kepler's equation in universal variables, so
+// the orbit may be elliptic, parabolic or hyperbolic, and dt may be negative.
+// The computation is in double precision, so propagating a long time at once
+// is more accurate than many small steps.
+void propagateKepler(Vector2d& position, Vector2d& velocity, double mu, double dt);
+
+// Smallest distance to the primary along the conic
+double periapsis(const Vector2d& position, const Vector2d& velocity, double mu);
+
+#endif // KEPLER_HPP
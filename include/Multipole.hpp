@@ -0,0 +1,45 @@
+#ifndef MULTIPOLE_HPP
+#define MULTIPOLE_HPP
+
+#include <vector>
+#include <vector.hpp>
+
+// Forward declarations
+class ConvexPolygon;
+
+// Expansion of the gravity of an extended mass, seen from afar: the point mass
+// at its center of mass, plus its quadrupole moment about it. The mass lies in
+// the plane but the field still decreases as 1/r^2, so the moment is the 3D
+// traceless one restricted to the plane, that is the sum of
+// m (3 x x^T - |x|^2 I) over the mass. Even a disk has one.
+struct Multipole {
+    Vector2f center{0, 0};
+    float mass{0};
+    float xx{0};
+    float xy{0};
+    float yy{0};
+};
+
+// Multipole of a convex polygon of uniform density, about its center of mass
+Multipole polygonMultipole(const ConvexPolygon& polygon, float density);
+
+// Multipole of several masses together, about their common center of mass
+Multipole combineMultipoles(const std::vector<Multipole>& multipoles);
+
+// Field of the point mass and of the quadrupole at the given position, without
+// the gravitational constant, in the same convention as GravityKernel
+Vector2f multipoleField(const Multipole& multipole, const Vector2f& position);
+
+// Field of the quadrupole only
+Vector2f quadrupoleField(const Multipole& multipole, const Vector2f& position);
+
+// Correction to the field of a point mass at the offset r from the center of
+// an extended mass, whose multipoles are in its frame rotated by the given
+// angle. Far from the mass, it is the field of the quadrupole. Within
+// nearField of the center, the expansion does not converge, so the point
+// mass, of the given mass and squared softening, is replaced by the
+// expansions of the components, which are each much smaller than the whole.
+Vector2f extendedField(const Multipole& multipole, const std::vector<Multipole>& components,
+    float rotation, float nearField, float mass, float softening2, const Vector2f& r);
+
+#endif // MULTIPOLE_HPP
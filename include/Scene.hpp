@@ -4,18 +4,100 @@
 #include <cstddef>
 #include <cstdint>
 #include <vector>
-#include <set>
-#include <map>
 #include <memory>
 #include <cassert>
-#include <typeindex>
 #include <functional>
-#include <numeric>
+#include <limits>
+#include <algorithm>
+#include <iterator>
+#include <tuple>
+#include <array>
+#include <utility>
 
+// Entity IDs are handles made of an index in the entity list of the scene (the
+// low bits) and a version (the high bits). The version is incremented every
+// time an index is recycled, so that handles to removed entities do not refer
+// to the new entity reusing the index.
 typedef std::uint32_t EntityId;
 
+// Storage of the components of one type, in the order of the dense array of
+// their sparse set. Components are stored in a std::vector by default, but a
+// component type can opt in another layout by specializing this template with
+// the same interface, for example to store its fields in separate arrays. The
+// references are then proxy types.
+template <typename T>
+class ComponentStorage {
+public:
+    using Reference = T&;
+    using ConstReference = const T&;
+
+    template <typename... Args>
+    Reference emplace_back(Args&&... args) {
+        return _components.emplace_back(std::forward<Args>(args)...);
+    }
+
+    Reference operator[](std::size_t index) {
+        return _components[index];
+    }
+
+    ConstReference operator[](std::size_t index) const {
+        return _components[index];
+    }
+
+    std::size_t size() const {
+        return _components.size();
+    }
+
+    void swap(std::size_t i, std::size_t j) {
+        std::swap(_components[i], _components[j]);
+    }
+
+    // Moves the last component in place of the given one, so erasing is
+    // constant time but does not preserve the order of the components.
+    void erase(std::size_t index) {
+        if (index != _components.size() - 1) {
+            _components[index] = std::move(_components.back());
+        }
+        _components.pop_back();
+    }
+
+private:
+    std::vector<T> _components;
+};
+
 class Scene {
 public:
+    template <typename... Types>
+    class View;
+    template <typename... Types>
+    class Group;
+    class EntityRange;
+    class CommandBuffer;
+
+    template <typename T>
+    using ComponentRef = typename ComponentStorage<T>::Reference;
+    template <typename T>
+    using ConstComponentRef = typename ComponentStorage<T>::ConstReference;
+
+    static constexpr unsigned entityIndexBits{20};
+    static constexpr EntityId entityIndexMask{(EntityId{1} << entityIndexBits) - 1};
+    // Index marking the end of the free list, so the maximum number of
+    // simultaneous entities is entityIndexMask.
+    static constexpr EntityId nullEntityIndex{entityIndexMask};
+
+    static constexpr EntityId entityIndex(EntityId id) {
+        return id & entityIndexMask;
+    }
+
+    static constexpr EntityId entityVersion(EntityId id) {
+        return id >> entityIndexBits;
+    }
+
+    static constexpr EntityId makeEntityId(EntityId index, EntityId version) {
+        // The version wraps around when shifted out of the 32 bits
+        return (version << entityIndexBits) | index;
+    }
+
     // Scene is non-copyable
     Scene() = default;
     Scene(const Scene&) = delete;
@@ -23,77 +105,361 @@ public:
 
     EntityId createEntity();
     void removeEntity(EntityId id);
+    // Checks if the handle refers to an entity that has not been removed.
+    bool isValid(EntityId id) const;
 
     template <typename T>
     void registerComponent() {
-        _arrays[typeid(T)] = std::make_unique<ArrayModel<T>>();
+        const std::size_t typeId{componentTypeId<T>};
+        if (typeId >= _arrays.size()) {
+            _arrays.resize(typeId + 1);
+        }
+        _arrays[typeId] = std::make_unique<ArrayModel<T>>();
     }
 
     template <typename T, typename... Args>
-    T& assignComponent(EntityId id, Args&&... args) {
-        return getArray<T>().assign(id, std::forward<Args>(args)...);
+    ComponentRef<T> assignComponent(EntityId id, Args&&... args) {
+        assert(isValid(id));
+        ArrayModel<T>& array{getArray<T>()};
+        ComponentRef<T> component{array.assign(id, std::forward<Args>(args)...)};
+        array.markChanged(array.index(id), _tick);
+        if (array.owners.empty()) {
+            return component;
+        }
+        // Joining a group moves the component
+        addToGroups(array, id);
+        return array.get(id);
     }
 
     template <typename T>
-    const T& getComponent(EntityId id) const {
+    ConstComponentRef<T> getComponent(EntityId id) const {
+        assert(isValid(id));
         return getArray<T>().get(id);
     }
 
     template <typename T>
-    T& getComponent(EntityId id) {
+    ComponentRef<T> getComponent(EntityId id) {
+        assert(isValid(id));
         return getArray<T>().get(id);
     }
 
+    // Change tracking: each component remembers the tick at which it was last
+    // assigned or marked as changed. A system that wants to process only the
+    // changed components keeps the tick returned by advanceTick, and passes it
+    // to Scene::changed on its next update. Modifications through references
+    // are not tracked, code modifying a component has to either get it with
+    // patchComponent or call markChanged.
+
+    // Returns the current tick and starts a new one. Changes made from now on
+    // are more recent than the returned tick.
+    std::uint64_t advanceTick() {
+        return _tick++;
+    }
+
+    // Tick of the changes made now
+    std::uint64_t currentTick() const {
+        return _tick;
+    }
+
+    template <typename T>
+    void markChanged(EntityId id) {
+        assert(isValid(id));
+        ArrayModel<T>& array{getArray<T>()};
+        array.markChanged(array.index(id), _tick);
+    }
+
+    // Marks all the components of a type, for systems that stream through the
+    // storage and modify every component.
+    template <typename T>
+    void markAllChanged() {
+        getArray<T>().markAllChanged(_tick);
+    }
+
+    // Gets a component to modify it, and marks it as changed.
+    template <typename T>
+    ComponentRef<T> patchComponent(EntityId id) {
+        markChanged<T>(id);
+        return getComponent<T>(id);
+    }
+
+    template <typename T>
+    bool hasChanged(EntityId id, std::uint64_t since) const {
+        assert(isValid(id));
+        const ArrayModel<T>& array{getArray<T>()};
+        return array.changeTick(array.index(id)) > since;
+    }
+
+    // Tick of the last change of the component of an entity
+    template <typename T>
+    std::uint64_t changeTick(EntityId id) const {
+        assert(isValid(id));
+        const ArrayModel<T>& array{getArray<T>()};
+        return array.changeTick(array.index(id));
+    }
+
+    // Gives direct access to the storage of a component type, to stream
+    // through all the components. They are in the same order as the entities
+    // returned by the views having this component type as their smallest
+    // array. The storage must not be modified structurally.
+    template <typename T>
+    ComponentStorage<T>& components() {
+        return getArray<T>().storage();
+    }
+
+    // Entity owning each component of components<T>(), in the same order.
+    template <typename T>
+    const EntityId* componentEntities() const {
+        return getArray<T>().entities();
+    }
+
+    // Index of the component of an entity in components<T>(), until the
+    // storage changes structurally.
+    template <typename T>
+    std::size_t componentIndex(EntityId id) const {
+        assert(hasComponent<T>(id));
+        return getArray<T>().index(id);
+    }
+
     template <typename T>
     void eraseComponent(EntityId id) {
-        getArray<T>().erase(id);
+        assert(isValid(id));
+        ArrayModel<T>& array{getArray<T>()};
+        removeFromGroups(array, id);
+        array.erase(id);
     }
 
+    // Registers an owning group for the given components. The entities having
+    // all of them are kept packed at the front of each component array, in the
+    // same order, so that Scene::group can iterate on them without any lookup.
+    // The group is maintained when components are assigned or erased. A
+    // component array can be owned by several groups only if no entity can be
+    // in more than one of them, and two groups can share at most one
+    // component. Entering or leaving a group costs a few swaps per component,
+    // plus a rotation of the groups registered after it on a shared component,
+    // so groups with the most frequent changes should be registered last.
     template <typename... Types>
-    std::vector<std::tuple<EntityId, Types&...>> view() {
-        std::vector<std::tuple<EntityId, Types&...>> res;
-        std::tuple<ArrayModel<Types>&...> arrays(getArray<Types>()...);
-        for (EntityId id{0}; id < _maxEntityId; ++id) {
-            // Fold expression, it's equivalent to calling
-            // hasComponent<T1>(id) and hasComponent<T2>(id) and ...
-            if ((std::get<ArrayModel<Types>&>(arrays).contains(id) and ...)) {
-                res.emplace_back(id, std::get<ArrayModel<Types>&>(arrays).get(id)...);
-            }
-        }
-        return res;
+    void registerGroup() {
+        registerGroup(std::vector<std::size_t>{componentTypeId<Types>...});
+    }
+
+    // View over the entities having all the given components, and for which
+    // at least one of them changed after the tick since.
+    template <typename... Types>
+    View<Types...> changed(std::uint64_t since) {
+        return View<Types...>(since, getArray<Types>()...);
+    }
+
+    // Returns the range over a registered group, see Scene::Group.
+    template <typename... Types>
+    Group<Types...> group() {
+        return Group<Types...>(findGroup<Types...>(), getArray<Types>()...);
+    }
+
+    // Returns a lazy range over the entities having all the given components,
+    // see Scene::View.
+    template <typename... Types>
+    View<Types...> view() {
+        return View<Types...>(getArray<Types>()...);
     }
 
     template <typename T>
     EntityId findUnique() {
-        auto ids = view<T>();
-        assert(ids.size() == 1);
-        return std::get<0>(ids.front());
+        const ArrayModel<T>& array{getArray<T>()};
+        assert(array.size() == 1);
+        return array.entity(0);
     }
 
-    std::vector<EntityId> allEntities() const {
-        std::vector<EntityId> allIds(_maxEntityId);
-        std::iota(allIds.begin(), allIds.end(), 0);
-        std::vector<EntityId> res;
-        std::set_difference(allIds.begin(), allIds.end(),
-                _freeIds.begin(), _freeIds.end(), std::back_inserter(res));
-        return res;
-    }
+    // Returns a lazy range over the entities that are alive, see
+    // Scene::EntityRange.
+    EntityRange allEntities() const;
 
+    // Command buffer of the scene, to request structural changes while
+    // iterating. See Scene::CommandBuffer.
+    CommandBuffer& commands();
+
+    // Returns false for handles to removed entities, even if the entity
+    // reusing their index has the component.
     template <typename T>
     bool hasComponent(EntityId id) const {
         return getArray<T>().contains(id);
     }
 
 private:
+    class ArrayConcept;
+
+    // Bookkeeping of an owning group. Each owned array keeps the entities of
+    // the group in a contiguous segment of its dense array. The segments of
+    // the groups owning an array are at the front of it, in the order the
+    // groups appear in ArrayConcept::owners.
+    struct GroupData {
+        // Sorted component type IDs, to find the group
+        std::vector<std::size_t> typeIds;
+        std::vector<ArrayConcept*> arrays;
+        std::size_t size{0};
+    };
+
     // Type erasure idiom to store component arrays of any type. The base class
     // is called the concept, and the derived class the model. The base class
     // just defines the functions we need to call without knowing the underlying
     // type. In this case, it's only erase, since we need to call it when we
     // delete an entity (and we don't know the component types in that context).
+    //
+    // The concept also holds the mapping between entity IDs and indices in the
+    // component array, since it does not depend on the component type. It is a
+    // sparse set: the dense array lists the entities in the same order as the
+    // components, and the sparse array maps an entity ID to its index in the
+    // dense array. The sparse array is split in fixed-size pages that are only
+    // allocated when an entity in their range gets a component, so that
+    // components only assigned to a few entities with large IDs don't cost a
+    // huge array.
     class ArrayConcept {
     public:
+        // Owning groups of this array, in the order of their segments
+        std::vector<GroupData*> owners;
+
         virtual ~ArrayConcept() = default;
         virtual void erase(EntityId id) = 0;
+
+        // The sparse array is indexed by entity index, and the dense array
+        // holds the full handle, which lets us reject stale handles.
+        bool contains(EntityId id) const {
+            const std::size_t page{entityIndex(id) / pageSize};
+            if (page >= _sparse.size() or _sparse[page].empty()) {
+                return false;
+            }
+            const std::size_t i{_sparse[page][entityIndex(id) % pageSize]};
+            return i != npos and _dense[i] == id;
+        }
+
+        std::size_t size() const {
+            return _dense.size();
+        }
+
+        EntityId entity(std::size_t index) const {
+            return _dense[index];
+        }
+
+        const EntityId* entities() const {
+            return _dense.data();
+        }
+
+        std::uint64_t changeTick(std::size_t index) const {
+            return _changeTicks[index];
+        }
+
+        void markChanged(std::size_t index, std::uint64_t tick) {
+            _changeTicks[index] = tick;
+        }
+
+        void markAllChanged(std::uint64_t tick) {
+            std::fill(_changeTicks.begin(), _changeTicks.end(), tick);
+        }
+
+        std::size_t index(EntityId id) const {
+            assert(contains(id));
+            return sparseSlot(id);
+        }
+
+        // Swaps two entities and their components in the dense arrays
+        void swapEntries(std::size_t i, std::size_t j) {
+            if (i != j) {
+                std::swap(_dense[i], _dense[j]);
+                std::swap(_changeTicks[i], _changeTicks[j]);
+                sparseSlot(_dense[i]) = i;
+                sparseSlot(_dense[j]) = j;
+                swapComponents(i, j);
+            }
+        }
+
+        // Moves the first entry of the range at the end, shifting the other
+        // ones by one position.
+        void rotateLeft(std::size_t first, std::size_t count) {
+            for (std::size_t i{first}; i + 1 < first + count; ++i) {
+                swapEntries(i, i + 1);
+            }
+        }
+
+        // Moves the last entry of the range at the front, shifting the other
+        // ones by one position.
+        void rotateRight(std::size_t first, std::size_t count) {
+            for (std::size_t i{first + count}; i > first + 1; --i) {
+                swapEntries(i - 2, i - 1);
+            }
+        }
+
+        // Index of the first entity of the group in the dense array
+        std::size_t segmentStart(const GroupData& group) const {
+            std::size_t start{0};
+            for (const GroupData* owner : owners) {
+                if (owner == &group) {
+                    return start;
+                }
+                start += owner->size;
+            }
+            assert(false);
+            return start;
+        }
+
+        // Number of entities in the owning groups, they are all before the
+        // ungrouped ones in the dense array.
+        std::size_t groupedSize() const {
+            std::size_t res{0};
+            for (const GroupData* owner : owners) {
+                res += owner->size;
+            }
+            return res;
+        }
+
+    protected:
+        static constexpr std::size_t pageSize{4096};
+        static constexpr std::size_t npos{std::numeric_limits<std::size_t>::max()};
+
+        // Entities having this component, in the same order as the components
+        std::vector<EntityId> _dense;
+        // Tick of the last change of each component, in the same order
+        std::vector<std::uint64_t> _changeTicks;
+        // Pages of indices in the dense array, npos for absent entities
+        std::vector<std::vector<std::size_t>> _sparse;
+
+        virtual void swapComponents(std::size_t i, std::size_t j) = 0;
+
+        std::size_t& sparseSlot(EntityId id) {
+            return _sparse[entityIndex(id) / pageSize][entityIndex(id) % pageSize];
+        }
+
+        std::size_t sparseSlot(EntityId id) const {
+            return _sparse[entityIndex(id) / pageSize][entityIndex(id) % pageSize];
+        }
+
+        // Adds an entity at the end of the dense array, allocating its page if
+        // needed.
+        void pushEntity(EntityId id) {
+            const std::size_t page{entityIndex(id) / pageSize};
+            if (page >= _sparse.size()) {
+                _sparse.resize(page + 1);
+            }
+            if (_sparse[page].empty()) {
+                _sparse[page].resize(pageSize, npos);
+            }
+            sparseSlot(id) = _dense.size();
+            _dense.push_back(id);
+            _changeTicks.push_back(0);
+        }
+
+        // Removes an entity by moving the last entity of the dense array in its
+        // place. Returns the index that was freed, so that the model can do the
+        // same with the component array.
+        std::size_t popEntity(EntityId id) {
+            const std::size_t removed{index(id)};
+            const EntityId last{_dense.back()};
+            _dense[removed] = last;
+            _changeTicks[removed] = _changeTicks.back();
+            sparseSlot(last) = removed;
+            sparseSlot(id) = npos;
+            _dense.pop_back();
+            _changeTicks.pop_back();
+            return removed;
+        }
     };
 
     // The derived class is template, so it can store the underlying array. It
@@ -102,60 +468,445 @@ private:
     class ArrayModel final : public ArrayConcept {
     public:
         template <typename... Args>
-        T& assign(EntityId id, Args&&... args) {
-            assert(not mapping.contains(id));
-            mapping.emplace(id, components.size());
+        ComponentRef<T> assign(EntityId id, Args&&... args) {
+            assert(not contains(id));
+            pushEntity(id);
             return components.emplace_back(std::forward<Args>(args)...);
         }
 
-        const T& get(EntityId id) const {
-            assert(contains(id));
-            return components[mapping.at(id)];
+        ConstComponentRef<T> get(EntityId id) const {
+            return components[index(id)];
         }
 
-        T& get(EntityId id) {
-            assert(contains(id));
-            return components[mapping.at(id)];
+        ComponentRef<T> get(EntityId id) {
+            return components[index(id)];
+        }
+
+        // Access by index in the dense array rather than by entity
+        ComponentRef<T> at(std::size_t index) {
+            return components[index];
         }
 
+        ComponentStorage<T>& storage() {
+            return components;
+        }
+
+        // Swap-and-pop, so erasing is constant time but does not preserve the
+        // order of the components.
         virtual void erase(EntityId id) override {
-            assert(contains(id));
-            std::size_t index{mapping.at(id)};
-            // Update all subsequent index mappings
-            for (auto& [otherId, otherIndex] : mapping) {
-                if (otherIndex > index) {
-                    otherIndex--;
+            components.erase(popEntity(id));
+        }
+
+    private:
+        ComponentStorage<T> components;
+
+        virtual void swapComponents(std::size_t i, std::size_t j) override {
+            components.swap(i, j);
+        }
+    };
+
+public:
+    // Lazy range over the entities having all the given components. It walks
+    // the dense array of the smallest component array and only checks whether
+    // the other arrays contain each entity, so building and iterating a view
+    // allocates nothing. Dereferencing an iterator gives a tuple with the
+    // entity ID and references to its components, to be unpacked with
+    // structured bindings:
+    //     for (auto [id, body, sprite] : scene.view<Body, Sprite>())
+    // The viewed component arrays must not be modified structurally (assign or
+    // erase) while iterating.
+    template <typename... Types>
+    class View {
+    public:
+        class Iterator {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = std::tuple<EntityId, ComponentRef<Types>...>;
+            using reference = value_type;
+            using pointer = void;
+            using difference_type = std::ptrdiff_t;
+
+            Iterator() = default;
+
+            Iterator(const View* view, std::size_t index):
+                _view{view},
+                _index{index} {
+                skipMissing();
+            }
+
+            value_type operator*() const {
+                return _view->get(_index);
+            }
+
+            Iterator& operator++() {
+                ++_index;
+                skipMissing();
+                return *this;
+            }
+
+            Iterator operator++(int) {
+                Iterator res{*this};
+                ++(*this);
+                return res;
+            }
+
+            bool operator==(const Iterator& other) const {
+                return _index == other._index;
+            }
+
+        private:
+            const View* _view{nullptr};
+            std::size_t _index{0};
+
+            // Advances until an entity having all the components is found
+            void skipMissing() {
+                while (_index < _view->_leading->size()
+                        and not _view->accepts(_index, _view->_leading->entity(_index))) {
+                    ++_index;
                 }
             }
-            components.erase(components.begin() + index);
-            mapping.erase(id);
+        };
+
+        View(ArrayModel<Types>&... arrays):
+            View(0, arrays...) {
         }
 
-        bool contains(EntityId id) const {
-            return mapping.contains(id);
+        // View filtering the entities with no change after the tick since
+        View(std::uint64_t since, ArrayModel<Types>&... arrays):
+            _arrays{&arrays...},
+            _leading{std::min({static_cast<const ArrayConcept*>(&arrays)...},
+                [] (const ArrayConcept* a, const ArrayConcept* b) {
+                    return a->size() < b->size();
+                })},
+            _since{since} {
+        }
+
+        Iterator begin() const {
+            return Iterator(this, 0);
+        }
+
+        Iterator end() const {
+            return Iterator(this, _leading->size());
+        }
+
+    private:
+        std::tuple<ArrayModel<Types>*...> _arrays;
+        // Smallest of the arrays, the one we iterate on
+        const ArrayConcept* _leading;
+        // Ticks start at 1, so all the components are more recent than 0
+        std::uint64_t _since;
+
+        bool accepts(std::size_t index, EntityId id) const {
+            if (not (std::get<ArrayModel<Types>*>(_arrays)->contains(id) and ...)) {
+                return false;
+            }
+            return _since == 0 or (changedSince<Types>(index, id) or ...);
+        }
+
+        template <typename T>
+        bool changedSince(std::size_t index, EntityId id) const {
+            const ArrayModel<T>* array{std::get<ArrayModel<T>*>(_arrays)};
+            const std::size_t arrayIndex{array == _leading ? index : array->index(id)};
+            return array->changeTick(arrayIndex) > _since;
+        }
+
+        std::tuple<EntityId, ComponentRef<Types>...> get(std::size_t index) const {
+            const EntityId id{_leading->entity(index)};
+            return {id, component<Types>(index, id)...};
+        }
+
+        // The leading array is accessed directly by index, the other ones
+        // through their sparse array.
+        template <typename T>
+        ComponentRef<T> component(std::size_t index, EntityId id) const {
+            ArrayModel<T>* array{std::get<ArrayModel<T>*>(_arrays)};
+            return array == _leading ? array->at(index) : array->get(id);
+        }
+    };
+
+    // Range over the entities of an owning group. Since the group keeps its
+    // entities packed and in the same order in all its arrays, iterating is a
+    // linear walk over contiguous arrays. As with views, dereferencing gives a
+    // tuple with the entity ID and references to the components, and the
+    // arrays must not be modified structurally while iterating.
+    template <typename... Types>
+    class Group {
+    public:
+        class Iterator {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = std::tuple<EntityId, ComponentRef<Types>...>;
+            using reference = value_type;
+            using pointer = void;
+            using difference_type = std::ptrdiff_t;
+
+            Iterator() = default;
+
+            Iterator(const Group* group, std::size_t index):
+                _group{group},
+                _index{index} {
+            }
+
+            value_type operator*() const {
+                return {_group->_entities[_index], std::get<Segment<Types>>(_group->_segments)[_index]...};
+            }
+
+            Iterator& operator++() {
+                ++_index;
+                return *this;
+            }
+
+            Iterator operator++(int) {
+                Iterator res{*this};
+                ++(*this);
+                return res;
+            }
+
+            bool operator==(const Iterator& other) const {
+                return _index == other._index;
+            }
+
+        private:
+            const Group* _group{nullptr};
+            std::size_t _index{0};
+        };
+
+        Group(const GroupData& data, ArrayModel<Types>&... arrays):
+            _entities{std::get<0>(std::tie(arrays...)).entities()
+                + std::get<0>(std::tie(arrays...)).segmentStart(data)},
+            _segments{Segment<Types>{&arrays, arrays.segmentStart(data)}...},
+            _size{data.size} {
+        }
+
+        Iterator begin() const {
+            return Iterator(this, 0);
+        }
+
+        Iterator end() const {
+            return Iterator(this, _size);
+        }
+
+        std::size_t size() const {
+            return _size;
         }
 
     private:
-        std::vector<T> components;
-        std::map<EntityId, std::size_t> mapping;
+        // Segment of the group in one of its arrays
+        template <typename T>
+        struct Segment {
+            ArrayModel<T>* array;
+            std::size_t start;
+
+            ComponentRef<T> operator[](std::size_t index) const {
+                return array->at(start + index);
+            }
+        };
+
+        // Start of the segment of the group in the entity list of the arrays
+        const EntityId* _entities;
+        std::tuple<Segment<Types>...> _segments;
+        std::size_t _size;
     };
 
-    // Maximum entity ID we have assigned so far.
-    EntityId _maxEntityId{0};
-    // List of entity IDs that can be recycled for new entities. Gives the
-    // smallest id first.
-    std::set<EntityId> _freeIds;
-    // Storage of component arrays, indexed by type_index
-    std::map<std::type_index, std::unique_ptr<ArrayConcept>> _arrays;
+    // Lazy range over the live entities of the scene. It walks the entity list
+    // and skips the free slots.
+    class EntityRange {
+    public:
+        class Iterator {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = EntityId;
+            using reference = EntityId;
+            using pointer = void;
+            using difference_type = std::ptrdiff_t;
+
+            Iterator() = default;
+
+            Iterator(const std::vector<EntityId>* entities, std::size_t index):
+                _entities{entities},
+                _index{index} {
+                skipFree();
+            }
+
+            EntityId operator*() const {
+                return (*_entities)[_index];
+            }
+
+            Iterator& operator++() {
+                ++_index;
+                skipFree();
+                return *this;
+            }
+
+            Iterator operator++(int) {
+                Iterator res{*this};
+                ++(*this);
+                return res;
+            }
+
+            bool operator==(const Iterator& other) const {
+                return _index == other._index;
+            }
+
+        private:
+            const std::vector<EntityId>* _entities{nullptr};
+            std::size_t _index{0};
+
+            void skipFree() {
+                while (_index < _entities->size() and entityIndex((*_entities)[_index]) != _index) {
+                    ++_index;
+                }
+            }
+        };
+
+        EntityRange(const std::vector<EntityId>& entities):
+            _entities{entities} {
+        }
+
+        Iterator begin() const {
+            return Iterator(&_entities, 0);
+        }
+
+        Iterator end() const {
+            return Iterator(&_entities, _entities.size());
+        }
+
+    private:
+        const std::vector<EntityId>& _entities;
+    };
+
+    // Records structural changes (assign, erase, remove) requested while the
+    // component arrays are iterated, and applies them later in bulk with
+    // apply(). Erasures and removals are sorted per component array, so each
+    // array is processed in one pass. The commands are applied by kind: first
+    // the component erasures, then the entity removals, then the assignments.
+    // Assignments to an entity removed in the meantime are dropped, and
+    // assigning a component that the entity already has replaces it.
+    // Creating an entity does not touch the component arrays, so it is done
+    // immediately, and the new handle can be used in the next commands.
+    class CommandBuffer {
+    public:
+        CommandBuffer(Scene& scene);
+
+        EntityId createEntity();
+        void removeEntity(EntityId id);
+
+        template <typename T, typename... Args>
+        void assignComponent(EntityId id, Args&&... args) {
+            const std::size_t typeId{componentTypeId<T>};
+            if (typeId >= _assignments.size()) {
+                _assignments.resize(typeId + 1);
+            }
+            if (not _assignments[typeId]) {
+                _assignments[typeId] = std::make_unique<PendingModel<T>>();
+            }
+            static_cast<PendingModel<T>&>(*_assignments[typeId]).components.emplace_back(
+                id, T(std::forward<Args>(args)...));
+        }
+
+        template <typename T>
+        void eraseComponent(EntityId id) {
+            _erasures.emplace_back(componentTypeId<T>, id);
+        }
+
+        void apply();
+
+    private:
+        // Pending assignments of one component type, type-erased like the
+        // component arrays
+        class PendingConcept {
+        public:
+            virtual ~PendingConcept() = default;
+            virtual void apply(Scene& scene) = 0;
+        };
+
+        template <typename T>
+        class PendingModel final : public PendingConcept {
+        public:
+            std::vector<std::pair<EntityId, T>> components;
+
+            virtual void apply(Scene& scene) override {
+                for (auto& [id, component] : components) {
+                    if (not scene.isValid(id)) {
+                        continue;
+                    } else if (scene.hasComponent<T>(id)) {
+                        scene.patchComponent<T>(id) = std::move(component);
+                    } else {
+                        scene.assignComponent<T>(id, std::move(component));
+                    }
+                }
+                components.clear();
+            }
+        };
+
+        Scene& _scene;
+        // Pairs of component type ID and entity
+        std::vector<std::pair<std::size_t, EntityId>> _erasures;
+        std::vector<EntityId> _removals;
+        // Indexed by component type ID
+        std::vector<std::unique_ptr<PendingConcept>> _assignments;
+    };
+
+private:
+    // Entity list, indexed by entity index. A live entity stores its own
+    // handle. A free slot stores the index of the next free slot (or
+    // nullEntityIndex) along with the version that its next entity will have,
+    // so the free slots form a linked list and creating or removing an entity
+    // is constant time.
+    std::vector<EntityId> _entities;
+    // Index of the first free slot in _entities
+    EntityId _freeHead{nullEntityIndex};
+    // Storage of component arrays, indexed by component type ID. Unregistered
+    // types have a null pointer.
+    std::vector<std::unique_ptr<ArrayConcept>> _arrays;
+    // Owning groups, behind pointers since the arrays point to them
+    std::vector<std::unique_ptr<GroupData>> _groups;
+    // Current tick for change tracking
+    std::uint64_t _tick{1};
+    CommandBuffer _commands{*this};
+
+    // Family counter giving a sequential ID to each component type, so that
+    // finding the array of a component is a single index in _arrays rather
+    // than a lookup by typeid. The IDs are assigned during static
+    // initialization, in no particular order, and are shared by all scenes.
+    static inline std::size_t componentTypeCount{0};
+    template <typename T>
+    static inline const std::size_t componentTypeId{componentTypeCount++};
 
     template <typename T>
     inline const ArrayModel<T>& getArray() const {
         // If this assert triggers, we probably forgot to register a component
         // in GameState::registerComponents.
-        assert(_arrays.contains(typeid(T)));
-        return dynamic_cast<const ArrayModel<T>&>(*_arrays.at(typeid(T)));
+        assert(componentTypeId<T> < _arrays.size() and _arrays[componentTypeId<T>]);
+        // The array at this index was created by registerComponent<T>, so the
+        // downcast is safe.
+        return static_cast<const ArrayModel<T>&>(*_arrays[componentTypeId<T>]);
     }
 
+    template <typename... Types>
+    const GroupData& findGroup() const {
+        std::array<std::size_t, sizeof...(Types)> typeIds{componentTypeId<Types>...};
+        std::sort(typeIds.begin(), typeIds.end());
+        auto it = std::find_if(_groups.begin(), _groups.end(), [&typeIds] (const auto& group) {
+            return std::equal(typeIds.begin(), typeIds.end(),
+                group->typeIds.begin(), group->typeIds.end());
+        });
+        // If this assert triggers, we probably forgot to register a group
+        // in GameState::registerComponents.
+        assert(it != _groups.end());
+        return **it;
+    }
+
+    // Puts the slot of a removed entity in the free list
+    void freeEntity(EntityId id);
+    void registerGroup(std::vector<std::size_t> typeIds);
+    // Updates the groups owning the array after a component was assigned
+    void addToGroups(ArrayConcept& array, EntityId id);
+    // Updates the groups owning the array before a component is erased
+    void removeFromGroups(ArrayConcept& array, EntityId id);
+    void addToGroup(GroupData& group, EntityId id);
+    void removeFromGroup(GroupData& group, EntityId id);
+
     template <typename T>
     inline ArrayModel<T>& getArray() {
         return const_cast<ArrayModel<T>&>(const_cast<const Scene&>(*this).getArray<T>());
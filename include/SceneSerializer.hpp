@@ -47,6 +47,7 @@ private:
     void loadAnimations(const nlohmann::json& value, EntityId id);
     void loadPlayer(const nlohmann::json& value, EntityId id);
     void loadLightSource(const nlohmann::json& value, EntityId id);
+    void loadGravitySource(const nlohmann::json& value, EntityId id);
     void loadMapElement(const nlohmann::json& value, EntityId id);
     void loadSoundEffects(const nlohmann::json& value, EntityId id);
 
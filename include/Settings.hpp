@@ -1,11 +1,13 @@
 #ifndef SETTINGS_HPP
 #define SETTINGS_HPP
 
+#include <cstddef>
 #include <map>
 #include <SFML/Window/Keyboard.hpp>
 #include <SFML/Window/VideoMode.hpp>
 #include <json.hpp>
 #include <Input.hpp>
+#include <Integrator.hpp>
 #include <serializers.hpp>
 
 struct SoundSettings {
@@ -16,8 +18,76 @@ struct SoundSettings {
 NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(SoundSettings, mainVolume,
     effectsVolume, musicVolume)
 
+enum class GravitySolver {
+    // Exact sum over all the pairs of bodies
+    Direct,
+    // Approximation with a quadtree, see BarnesHutTree
+    BarnesHut
+};
+NLOHMANN_JSON_SERIALIZE_ENUM(GravitySolver, {
+    {GravitySolver::Direct, "direct"},
+    {GravitySolver::BarnesHut, "barnesHut"}
+})
+
+NLOHMANN_JSON_SERIALIZE_ENUM(IntegratorType, {
+    {IntegratorType::Leapfrog, "leapfrog"},
+    {IntegratorType::Yoshida4, "yoshida4"},
+    {IntegratorType::RungeKutta4, "rungeKutta4"}
+})
+
+struct PhysicsSettings {
+    // Rate of the fixed physics steps, read when the game starts. Rendering
+    // interpolates between the steps, so it stays smooth at lower rates.
+    float stepsPerSecond{50};
+    bool renderInterpolation{true};
+    IntegratorType integrator{IntegratorType::RungeKutta4};
+    GravitySolver gravitySolver{GravitySolver::Direct};
+    // Opening angle of the Barnes-Hut solver, smaller is more accurate
+    float barnesHutTheta{0.5f};
+    // Bodies at least this heavy attract the other bodies even without the
+    // GravitySource component. Zero disables the threshold.
+    float gravitySourceMassThreshold{0};
+    // Threads integrating the bodies, zero for one per hardware thread. Read
+    // when the game starts.
+    std::size_t physicsThreads{0};
+    // Gives each body its own block of 2^level time steps, up to
+    // 2^maxBlockLevel, from its acceleration and jerk. Bodies then only need
+    // forces at the end of their block. Always integrates with leapfrog.
+    bool blockTimesteps{false};
+    unsigned maxBlockLevel{10};
+    // Fraction of |a| / |da/dt| that the block of a body lasts at most
+    float blockTimestepAccuracy{0.02f};
+    // A body that is not a source and passes so close to a point mass source
+    // that it would orbit it by one radian in less than this many steps is
+    // advanced on its conic around the source, and the other sources only
+    // perturb it. Only with the whole-system integrators, zero disables it.
+    float closeEncounterSteps{10};
+    // Sources with a PolygonBody pull with their quadrupole moment on top of
+    // their mass, and with each of their convex components within this many
+    // times their radius. Zero keeps them point masses.
+    float nearFieldRadii{2};
+    // From this time scale, the bodies are propagated analytically on their
+    // orbits when none of them thrusts or touches another one. Zero disables
+    // it.
+    float railsTimeScale{100};
+    // Steps between two keyframes of the bodies, and memory of the keyframes
+    // in bytes. Rewinding restores a keyframe and simulates the interval
+    // forward once, with the recorded thrust and collisions. A smaller
+    // interval makes it faster, and more memory rewinds further back.
+    unsigned keyframeInterval{50};
+    std::size_t rewindMemory{64 * 1024 * 1024};
+    // Time predicted ahead for the map, and step of the prediction, in seconds
+    float predictionHorizon{600};
+    float predictionTimeStep{0.1f};
+};
+// Each setting is optional in settings.json, so that the files written
+// before a setting existed still load with its default value
+void to_json(nlohmann::json& j, const PhysicsSettings& settings);
+void from_json(const nlohmann::json& j, PhysicsSettings& settings);
+
 struct Settings {
     SoundSettings soundSettings;
+    PhysicsSettings physicsSettings;
     sf::VideoMode videoMode{sf::VideoMode::getDesktopMode()};
     std::map<sf::Keyboard::Key, GameInput> gameKeyboardMapping {
         {sf::Keyboard::Z, GameInput::RcsUp},
@@ -58,8 +128,8 @@ struct Settings {
     static void saveSettings(const Settings& settings);
 };
 
-NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(Settings, soundSettings, videoMode,
-    gameKeyboardMapping, gameControllerMapping, mapKeyboardMapping,
-    mapControllerMapping)
+// The physics settings are optional too
+void to_json(nlohmann::json& j, const Settings& settings);
+void from_json(const nlohmann::json& j, Settings& settings);
 
 #endif // SETTINGS_HPP
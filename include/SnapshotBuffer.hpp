@@ -0,0 +1,95 @@
+#ifndef SNAPSHOTBUFFER_HPP
+#define SNAPSHOTBUFFER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+#include <vector.hpp>
+
+// Forward declarations
+class Scene;
+typedef std::uint32_t EntityId;
+
+// Ring buffer of keyframes of the dynamic state of the bodies, so that time is
+// rewound by restoring a keyframe and simulating forward, rather than by
+// integrating backwards. It also records the bodies changed outside of the
+// physics steps, by thrust or collisions, so that simulating forward follows
+// the recorded history rather than only gravity. The oldest keyframes are
+// dropped with their changes to keep both under the memory budget.
+class SnapshotBuffer {
+public:
+    // Zero disables the recording
+    void setMemoryBudget(std::size_t bytes);
+
+    // Records the bodies of the scene at the given step. The keyframes and
+    // changes at and after this step are dropped, they belong to a history
+    // that is being rewritten.
+    void record(long long int step, Scene& scene);
+
+    // Restores the latest keyframe at or before the given step, and returns
+    // its step in restoredStep. Returns false if there is no such keyframe.
+    // Bodies created after the keyframe are left untouched.
+    bool restore(long long int step, Scene& scene, long long int& restoredStep) const;
+    // Whether there is a keyframe at exactly the given step
+    bool contains(long long int step) const;
+    // Drops all the keyframes and changes
+    void clear();
+
+    // Records the state at the start of the given step of the bodies changed
+    // after the tick since. The changes at and after this step are dropped,
+    // as for the keyframes.
+    void recordChanges(long long int step, Scene& scene, std::uint64_t since);
+    // Sets the bodies changed at the start of the given step to the state
+    // recorded for them
+    void replayChanges(long long int step, Scene& scene) const;
+
+    std::size_t size() const;
+    std::size_t memoryUsage() const;
+    // Memory of a keyframe of the given number of bodies
+    static std::size_t keyframeSize(std::size_t bodies);
+
+private:
+    struct Keyframe {
+        long long int step;
+        std::vector<EntityId> entities;
+        std::vector<Vector2f> positions;
+        std::vector<Vector2f> velocities;
+        std::vector<float> rotations;
+        std::vector<float> angularVelocities;
+    };
+
+    struct Change {
+        long long int step;
+        EntityId entity;
+        Vector2f position;
+        Vector2f velocity;
+        float rotation;
+        float angularVelocity;
+    };
+
+    // Keyframes in a ring, the oldest at _first. The memory of overwritten
+    // keyframes is reused.
+    std::vector<Keyframe> _keyframes;
+    std::size_t _first{0};
+    std::size_t _size{0};
+    std::size_t _budget{0};
+    // Memory of the arrays of all the keyframes, including the overwritten
+    // ones that keep their memory
+    std::size_t _keyframeMemory{0};
+    // Sorted by step, and none before the oldest keyframe
+    std::deque<Change> _changes;
+
+    Keyframe& at(std::size_t i);
+    const Keyframe& at(std::size_t i) const;
+    void setCapacity(std::size_t capacity);
+    // Drops the changes older than the oldest keyframe
+    void dropOldChanges();
+    // Drops the oldest keyframes, and their changes, until the keyframes and
+    // the changes fit in the budget. The memory of the dropped keyframes is
+    // freed.
+    void fitBudget();
+    static std::size_t arraysMemory(const Keyframe& keyframe);
+};
+
+#endif // SNAPSHOTBUFFER_HPP
@@ -0,0 +1,93 @@
+#ifndef SUPPORTFUNCTIONS_HPP
+#define SUPPORTFUNCTIONS_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <vector>
+#include <vector.hpp>
+
+// Support functions of convex shapes in world coordinates, for GJK and EPA. A
+// support function returns the point of the shape furthest in a direction.
+// They are small functors rather than std::function, so that the collision
+// routines templated on them inline each query.
+
+// A single point, such as the center of a circle
+struct PointSupport {
+    Vector2f point;
+
+    Vector2f operator()(const Vector2f&) const {
+        return point;
+    }
+};
+
+// Convex polygon given by its vertices in world coordinates, such as the world
+// vertices of a component of a polygon body. They are kept by reference.
+class ConvexSupport {
+public:
+    ConvexSupport(const std::vector<Vector2f>& vertices):
+        _vertices{vertices} {
+    }
+
+    Vector2f operator()(const Vector2f& direction) const {
+        std::size_t best{0};
+        float bestProduct{dot(direction, _vertices[0])};
+        for (std::size_t i{1}; i < _vertices.size(); ++i) {
+            const float product{dot(direction, _vertices[i])};
+            if (product > bestProduct) {
+                bestProduct = product;
+                best = i;
+            }
+        }
+        return _vertices[best];
+    }
+
+private:
+    const std::vector<Vector2f>& _vertices;
+};
+
+// Convex polygon with exactly N vertices. They are copied in the functor, so
+// a query is only N dot products that the compiler unrolls. Triangles and
+// quadrilaterals are the most common components.
+template <std::size_t N>
+class FixedConvexSupport {
+public:
+    FixedConvexSupport(const std::vector<Vector2f>& vertices) {
+        std::copy_n(vertices.begin(), N, _vertices.begin());
+    }
+
+    Vector2f operator()(const Vector2f& direction) const {
+        std::size_t best{0};
+        float bestProduct{dot(direction, _vertices[0])};
+        for (std::size_t i{1}; i < N; ++i) {
+            const float product{dot(direction, _vertices[i])};
+            if (product > bestProduct) {
+                bestProduct = product;
+                best = i;
+            }
+        }
+        return _vertices[best];
+    }
+
+private:
+    std::array<Vector2f, N> _vertices;
+};
+
+// Calls function with the support function of a convex polygon given by its
+// world vertices, specialized on the number of vertices of the small ones
+template <typename Function>
+void withConvexSupport(const std::vector<Vector2f>& vertices, Function&& function) {
+    switch (vertices.size()) {
+        case 3:
+            function(FixedConvexSupport<3>(vertices));
+            break;
+        case 4:
+            function(FixedConvexSupport<4>(vertices));
+            break;
+        default:
+            function(ConvexSupport(vertices));
+            break;
+    }
+}
+
+#endif // SUPPORTFUNCTIONS_HPP
@@ -0,0 +1,53 @@
+#ifndef SWEEPANDPRUNE_HPP
+#define SWEEPANDPRUNE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include <vector.hpp>
+
+// Broad phase of the collision detection, with sweep and prune on the x axis.
+// The bounds of the boxes on x are kept sorted between updates. The boxes move
+// little from one update to the next, so insertion sort restores the order in
+// nearly linear time. A sweep along the bounds then finds the boxes overlapping
+// on x, and keeps the pairs that also overlap on y.
+class SweepAndPrune {
+public:
+    // Axis-aligned bounding box in world coordinates
+    struct Box {
+        Vector2f min;
+        Vector2f max;
+    };
+
+    // Finds the pairs of overlapping boxes. The bounds keep their order from
+    // the previous update as long as the number of boxes does not change, so
+    // a box should keep its index between updates. The result is correct in
+    // any case, only slower. This does not allocate once the buffers reached
+    // their size.
+    void update(const std::vector<Box>& boxes);
+
+    // Pairs of indices of overlapping boxes found by the last update, with the
+    // lower index first, sorted so that they do not depend on the sweep order.
+    // Boxes that only touch overlap.
+    const std::vector<std::pair<std::uint32_t, std::uint32_t>>& getPairs() const;
+
+private:
+    // Lower or upper bound of a box on the x axis
+    struct Bound {
+        float value;
+        // Index of the box, shifted left by one, and one for an upper bound
+        std::uint32_t data;
+    };
+
+    std::vector<Bound> _bounds;
+    // Boxes overlapping the sweep line, and the index of each box in it
+    std::vector<std::uint32_t> _active;
+    std::vector<std::uint32_t> _activeSlots;
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> _pairs;
+
+    // Orders the bounds by value, with the lower bounds first on equality
+    static bool less(const Bound& a, const Bound& b);
+};
+
+#endif // SWEEPANDPRUNE_HPP
@@ -0,0 +1,54 @@
+#ifndef THREADPOOL_HPP
+#define THREADPOOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads running parallel loops. The loop is cut into
+// chunks that the threads pick in any order, so the function must only write
+// to state owned by its range for the result not to depend on the number of
+// threads.
+class ThreadPool {
+public:
+    // Starts threads - 1 workers, the thread calling parallelFor being the
+    // last one. Zero uses one thread per hardware thread.
+    explicit ThreadPool(std::size_t threads = 0);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Number of threads running the loops, including the calling thread
+    std::size_t size() const;
+
+    // Calls function(begin, end) on disjoint ranges covering [0, count), and
+    // returns when all of them are done. Loops of at most grain iterations
+    // run on the calling thread only, since waking up the workers would cost
+    // more than it saves.
+    void parallelFor(std::size_t count, std::size_t grain,
+        const std::function<void(std::size_t, std::size_t)>& function);
+
+private:
+    std::vector<std::thread> _workers;
+    std::mutex _mutex;
+    std::condition_variable _workAvailable;
+    std::condition_variable _workDone;
+    // Current loop, the generation counting the loops started so far
+    const std::function<void(std::size_t, std::size_t)>* _function{nullptr};
+    std::size_t _count{0};
+    std::size_t _chunkSize{0};
+    std::atomic<std::size_t> _nextChunk{0};
+    std::size_t _busyWorkers{0};
+    std::uint64_t _generation{0};
+    bool _stopping{false};
+
+    void workerLoop();
+    void runChunks();
+};
+
+#endif // THREADPOOL_HPP
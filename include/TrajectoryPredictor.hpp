@@ -0,0 +1,152 @@
+#ifndef TRAJECTORYPREDICTOR_HPP
+#define TRAJECTORYPREDICTOR_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+#include <vector.hpp>
+#include <GravityKernel.hpp>
+#include <Multipole.hpp>
+
+// Forward declarations
+class Scene;
+class PhysicsSystem;
+struct PhysicsSettings;
+typedef std::uint32_t EntityId;
+
+// Predicts the trajectories of the bodies on a worker thread, for the map. The
+// state of the bodies is copied when a prediction starts, so the game goes on
+// while the worker integrates, and the results are published as a whole so
+// that reading them never waits for the worker.
+//
+// The gravity sources are predicted first, in a table of their positions at
+// each step. The other bodies only feel the sources, so the trajectory of one
+// of them is predicted again from the table alone when it is invalidated. The
+// sources pull as in PhysicsSystem, the polygons with their multipoles.
+class TrajectoryPredictor {
+public:
+    struct Prediction {
+        // Counts the published predictions, to tell when they change
+        std::uint64_t generation{0};
+        // The trajectory of entities[k] is the polyline from points[offsets[k]]
+        // to points[offsets[k + 1]], in world coordinates
+        std::vector<EntityId> entities;
+        std::vector<std::size_t> offsets;
+        std::vector<Vector2f> points;
+    };
+
+    explicit TrajectoryPredictor(const PhysicsSettings& settings);
+    ~TrajectoryPredictor();
+    TrajectoryPredictor(const TrajectoryPredictor&) = delete;
+    TrajectoryPredictor& operator=(const TrajectoryPredictor&) = delete;
+
+    // Marks the trajectory of a body as wrong, because its controls changed
+    // or it collided. The gravity sources are only predicted again when half
+    // of the predicted time has elapsed, since the bodies colliding with them
+    // are too light to change their trajectory much.
+    void invalidate(EntityId id);
+
+    // Starts a new prediction from the current state of the scene when some
+    // trajectories were invalidated, or when half of the predicted time has
+    // elapsed. Only the bodies having a MapElement are predicted.
+    void update(Scene& scene, const PhysicsSystem& physics);
+
+    // Latest published prediction, empty until the first one is done
+    std::shared_ptr<const Prediction> getPrediction() const;
+
+private:
+    // Source with a PolygonBody, with its shape in its own frame, turning at
+    // a constant rate
+    struct ExtendedSource {
+        // Index in the source arrays
+        std::size_t source;
+        Multipole multipole;
+        std::vector<Multipole> componentMultipoles;
+        float nearField;
+        float rotation;
+        float angularVelocity;
+    };
+
+    // State of the bodies at the start of a prediction, and the parameters
+    // of the settings, which the worker must not read while they may change
+    struct Job {
+        // Whether the sources are predicted again, otherwise only the given
+        // bodies are predicted from the table of the last full job
+        bool full;
+        double time;
+        double horizon;
+        double timeStep;
+        float gravitationalConstant;
+        std::vector<EntityId> sourceEntities;
+        std::vector<Vector2f> sourcePositions;
+        std::vector<Vector2f> sourceVelocities;
+        std::vector<float> sourceMasses;
+        // Squared Plummer softening of the sources
+        std::vector<float> sourceSoftenings;
+        // Radius of the circle sources, zero for the others
+        std::vector<float> sourceRadii;
+        std::vector<ExtendedSource> extendedSources;
+        std::vector<EntityId> entities;
+        std::vector<Vector2f> positions;
+        std::vector<Vector2f> velocities;
+    };
+
+    const PhysicsSettings& _settings;
+    // Maximum number of points of a trajectory
+    static constexpr std::size_t _maxPoints{512};
+
+    // State of the main thread
+    std::vector<EntityId> _invalidated;
+    bool _fullInvalidation{true};
+    // Time of the last full job
+    double _tableTime{0};
+
+    // Shared state
+    std::optional<Job> _job;
+    std::atomic<bool> _fullJobPending{false};
+    std::atomic<bool> _stopping{false};
+    mutable std::mutex _mutex;
+    std::condition_variable _jobAvailable;
+    std::shared_ptr<const Prediction> _prediction;
+
+    // State of the worker: positions of the sources at each step, and the
+    // trajectories of the other bodies from the last jobs
+    GravityKernel _gravityKernel{bestGravityKernel()};
+    double _workerTableTime{0};
+    double _workerTimeStep{0};
+    std::size_t _workerSteps{0};
+    std::vector<EntityId> _workerSources;
+    std::vector<float> _workerMasses;
+    std::vector<float> _workerSoftenings;
+    std::vector<float> _workerRadii;
+    std::vector<ExtendedSource> _workerExtended;
+    std::vector<Vector2f> _table;
+    std::vector<EntityId> _trajectoryEntities;
+    std::vector<std::vector<Vector2f>> _trajectories;
+    std::uint64_t _generation{0};
+    std::thread _worker;
+
+    void workerLoop();
+    // Returns false if the job was abandoned for a newer full job
+    bool predictSources(const Job& job);
+    // Predicts a body from the table, until the end of the table or until it
+    // hits a source
+    void predictBody(const Job& job, const Vector2f& position, const Vector2f& velocity,
+        std::vector<Vector2f>& trajectory) const;
+    // Position of the sources at the given time from the start of the table
+    void interpolateSources(double time, std::vector<Vector2f>& positions) const;
+    // Field of the sources at the given positions and time from the start of
+    // the table, without the gravitational constant. The source of index self
+    // does not pull, none if it is the number of sources.
+    Vector2f computeField(const std::vector<Vector2f>& sources, const Vector2f& position,
+        std::size_t self, double time) const;
+    void publish();
+};
+
+#endif // TRAJECTORYPREDICTOR_HPP
@@ -1,6 +1,7 @@
 #ifndef BODY_HPP
 #define BODY_HPP
 
+#include <limits>
 #include <vector>
 #include <SFML/Graphics/Sprite.hpp>
 #include <SFML/Graphics/Rect.hpp>
@@ -8,9 +9,8 @@
 #include <vector.hpp>
 #include <serializers.hpp>
 #include <polygon.hpp>
-
-class Scene;
-typedef uint32_t EntityId;
+#include <Multipole.hpp>
+#include <Scene.hpp>
 
 struct Body {
 	float density;
@@ -29,15 +29,82 @@ struct Body {
 
 	Vector2f localToWorld(const Vector2f& point) const;
 	Vector2f worldToLocal(const Vector2f& point) const;
-    std::vector<Vector2f> shadowTerminator(const Vector2f& lightSource, const Scene& scene, EntityId id) const;
 };
 NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(Body, density, position, velocity, rotation, angularVelocity, restitution, friction)
 
+struct BodyRef;
+
+// Bodies are stored in the scene as a structure of arrays, so that the physics
+// can stream through the fields it updates at each step without loading the
+// other ones. The x and y coordinates of vectors stay together, so that
+// BodyRef can refer to them as Vector2f.
+template <>
+class ComponentStorage<Body> {
+public:
+    using Reference = BodyRef;
+    using ConstReference = Body;
+
+    std::vector<float> densities;
+    std::vector<Vector2f> positions;
+    std::vector<Vector2f> velocities;
+    std::vector<float> rotations;
+    std::vector<float> angularVelocities;
+    std::vector<float> restitutions;
+    std::vector<float> frictions;
+    std::vector<Vector2f> centersOfMass;
+    std::vector<float> momentsOfInertia;
+    std::vector<float> masses;
+
+    template <typename... Args>
+    Reference emplace_back(Args&&... args);
+    Reference operator[](std::size_t index);
+    ConstReference operator[](std::size_t index) const;
+    std::size_t size() const;
+    void swap(std::size_t i, std::size_t j);
+    void erase(std::size_t index);
+
+private:
+    void push_back(const Body& body);
+};
+
+// Reference to a body in ComponentStorage<Body>. It has the fields of Body as
+// references, so that code using bodies does not depend on their layout. It
+// converts to a Body by copy, and it can also refer to a standalone Body.
+struct BodyRef {
+    float& density;
+    Vector2f& position;
+    Vector2f& velocity;
+    float& rotation;
+    float& angularVelocity;
+    float& restitution;
+    float& friction;
+    Vector2f& centerOfMass;
+    float& momentOfInertia;
+    float& mass;
+
+    BodyRef(Body& body);
+    BodyRef(ComponentStorage<Body>& storage, std::size_t index);
+    BodyRef(const BodyRef&) = default;
+    // Assignments copy the fields, as for a reference
+    BodyRef& operator=(const Body& body);
+    BodyRef& operator=(const BodyRef& other);
+    operator Body() const;
+
+	Vector2f localToWorld(const Vector2f& point) const;
+	Vector2f worldToLocal(const Vector2f& point) const;
+};
+
+template <typename... Args>
+BodyRef ComponentStorage<Body>::emplace_back(Args&&... args) {
+    push_back(Body{std::forward<Args>(args)...});
+    return (*this)[size() - 1];
+}
+
 struct CircleBody {
 	float radius;
 
 	CircleBody() = default;
-	CircleBody(Body& body, float radius);
+	CircleBody(BodyRef body, float radius);
 	std::vector<Vector2f> shadowTerminator(const Vector2f& lightSource, const Body& body) const;
 };
 NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(CircleBody, radius)
@@ -45,11 +112,33 @@ NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(CircleBody, radius)
 struct PolygonBody {
 	std::vector<Vector2f> vertices;
     std::vector<ConvexPolygon> components;
+    // Gravity of the whole body for the far field, and of each component for
+    // the near field, relative to the center of mass in the frame of the body
+    Multipole multipole;
+    std::vector<Multipole> componentMultipoles;
+    // Distance from the center of mass to the farthest vertex, so that the
+    // body is in the circle of this radius around its position
+    float radius;
+    // Vertices of the body and of each component in world coordinates, at
+    // the position and rotation of the last call to updateWorldVertices
+    std::vector<Vector2f> worldVertices;
+    std::vector<std::vector<Vector2f>> worldComponents;
+    // Change tick of the body when the world vertices were placed, none
+    // before the first update
+    std::uint64_t worldTick{std::numeric_limits<std::uint64_t>::max()};
 
 	PolygonBody() = default;
-	PolygonBody(Body& body, const std::vector<Vector2f>& vertices);
-	std::vector<Vector2f> shadowTerminator(const Vector2f& lightSource, const Body& body) const;
-	static Vector2f supportFunction(const Vector2f& direction, const ConvexPolygon& component, const Body& body);
+	PolygonBody(BodyRef body, const std::vector<Vector2f>& vertices);
+	// Moves the world vertices to the body, only if it changed since the last
+	// call, so that the trigonometry runs once per body and per step. The
+	// tick is the change tick of the body in the scene.
+	void updateWorldVertices(const Body& body, std::uint64_t tick);
+	// Whether the world vertices are placed for the given change tick
+	bool hasWorldVertices(std::uint64_t tick) const;
+	// The world vertices are used only when the body is drawn where they are,
+	// otherwise the vertices are moved to the given body
+	std::vector<Vector2f> shadowTerminator(const Vector2f& lightSource, const Body& body,
+		bool atWorldVertices) const;
 };
 NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(PolygonBody, vertices)
 
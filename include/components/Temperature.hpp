@@ -16,12 +16,18 @@ NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(Temperature, conductivity, specificCapacity)
 struct CircleTemperature {
     PolarField<float> field;
     CircleTemperatureGraphics graphics;
+    // Bound on the change of any cell since the component was last marked
+    // changed, see ThermodynamicsSystem
+    float unmarkedChange{0};
 };
 NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(CircleTemperature, field)
 
 struct PolygonTemperature {
     GridField<float> field;
     PolygonTemperatureGraphics graphics;
+    // Bound on the change of any cell since the component was last marked
+    // changed, see ThermodynamicsSystem
+    float unmarkedChange{0};
 };
 NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(PolygonTemperature, field)
 
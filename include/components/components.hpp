@@ -27,6 +27,19 @@ struct LightSource {
 };
 NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(LightSource, brightness)
 
+// Bodies that attract other bodies. The gravity of the other bodies (ships,
+// debris) is neglected, they are only attracted by the sources.
+struct GravitySource {
+	// Plummer softening length. The field of the source is bounded within
+	// about this distance of its center, rather than diverging, which keeps
+	// two sources passing through each other stable. Zero is a point mass.
+	float softening{0};
+};
+
+// The softening is optional in the saves
+void to_json(nlohmann::json& j, const GravitySource& gravitySource);
+void from_json(const nlohmann::json& j, GravitySource& gravitySource);
+
 enum class MapElementType {
 	CelestialBody,
 	Ship
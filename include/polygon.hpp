@@ -10,8 +10,11 @@ class ConvexPolygon {
 public:
 	ConvexPolygon(const std::vector<Vector2f>& vertices);
     Vector2f supportFunction(const Vector2f& direction) const;
+    const std::vector<Vector2f>& getVertices() const;
 	float momentOfInertia(float density, const Vector2f& axis) const;
 	std::pair<float, Vector2f> areaAndCenterOfMass() const;
+    // Integrals of x^2, xy and y^2 over the area, about the center of mass
+    std::array<float, 3> secondMoments() const;
     // Checks if a convex polygon contains a given point by checking if it is on
     // the right side of each edge, going clockwise.
     bool contains(const Vector2f& P) const;
@@ -19,6 +19,7 @@
 #include <InputManager.hpp>
 #include <Scene.hpp>
 #include <SceneSerializer.hpp>
+#include <TrajectoryPredictor.hpp>
 #include <Event.hpp>
 #include <Input.hpp>
 
@@ -67,6 +68,7 @@ private:
     RenderSystem _renderSystem;
     SoundEffectsSystem _soundEffectsSystem;
     ThermodynamicsSystem _thermodynamicsSystem;
+    TrajectoryPredictor _trajectoryPredictor;
     SceneSerializer _serializer;
     const float _rotationSpeed{3};
     const float _zoomSpeed{15.f};
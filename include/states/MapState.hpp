@@ -1,6 +1,10 @@
 #ifndef MAPSTATE_HPP
 #define MAPSTATE_HPP
 
+#include <cstdint>
+#include <vector>
+#include <SFML/Graphics/VertexArray.hpp>
+#include <TGUI/Backend/Renderer/SFML-Graphics/CanvasSFML.hpp>
 #include <TGUI/Widgets/Group.hpp>
 #include <TGUI/Widgets/Picture.hpp>
 #include <states/AbstractState.hpp>
@@ -15,6 +19,8 @@ namespace tgui {
 template <typename T>
 class ResourceManager;
 class Scene;
+class PhysicsSystem;
+class TrajectoryPredictor;
 struct Settings;
 
 class MapState : public AbstractState {
@@ -23,7 +29,9 @@ public:
         StateStack& stack,
         ResourceManager<tgui::Texture>& tguiTextureManager,
         const Settings& settings,
-        Scene& scene);
+        Scene& scene,
+        const PhysicsSystem& physicsSystem,
+        const TrajectoryPredictor& trajectoryPredictor);
     virtual tgui::Widget::Ptr buildGui() override;
     virtual bool update(sf::Time dt) override;
     virtual bool handleEvent(const sf::Event& event) override;
@@ -32,13 +40,27 @@ public:
 private:
     ResourceManager<tgui::Texture>& _tguiTextureManager;
     Scene& _scene;
+    const PhysicsSystem& _physicsSystem;
+    const TrajectoryPredictor& _trajectoryPredictor;
     InputManager<MapInput> _inputManager;
     tgui::Group::Ptr _mapIcons{tgui::Group::create()};
+    tgui::CanvasSFML::Ptr _trajectoryCanvas{tgui::CanvasSFML::create()};
+    // Predicted trajectories in world coordinates, built again when the
+    // generation of the prediction changes
+    std::vector<sf::VertexArray> _trajectories;
+    std::uint64_t _trajectoryGeneration{0};
+    const sf::Color _trajectoryColor{255, 255, 255, 96};
     tgui::Picture::Ptr _background;
     const float _zoomSpeed{15};
     float _scale{50};
     const float _minScale{25};
     const float _maxScale{200};
+    // Tick of the last update, see Scene::advanceTick
+    std::uint64_t _lastTick{0};
+    // Whether all the icons have to be moved at the next update
+    bool _viewChanged{true};
+
+    void drawTrajectories(const Vector2f& playerPos);
 };
 
 #endif // MAPSTATE_HPP
@@ -1,19 +1,21 @@
 #ifndef COLLISIONSYSTEM_HPP
 #define COLLISIONSYSTEM_HPP
 
+#include <array>
 #include <vector>
 #include <cstddef>
 #include <cstdint>
-#include <functional>
 #include <queue>
+#include <unordered_map>
 #include <utility>
 #include <vector.hpp>
+#include <SweepAndPrune.hpp>
 
 // Forward declarations
 class Scene;
-struct Body;
+struct BodyRef;
 struct CircleBody;
-class SupportFunction;
+struct PolygonBody;
 struct Event;
 typedef std::uint32_t EntityId;
 
@@ -22,19 +24,62 @@ public:
 	CollisionSystem(Scene& scene);
 	void update();
     std::queue<Event> queueEvents();
+	// Number of pairs of colliders remembered from the last update
+	std::size_t getContactCacheSize() const;
 
 private:
-	typedef std::function<Vector2f(const Vector2f&)> SupportFunction;
-
 	static constexpr float eps{0.0001f};
 	Scene& _scene;
 	std::queue<Event> _collisionEvents;
 
+	// Circle or convex component of a polygon in the broad phase. The circles
+	// come first, then the components, each in the order of their group, so
+	// that the pairs come in the same order as testing all of them.
+	struct Collider {
+		EntityId id;
+		// Null for a component
+		const CircleBody* circle;
+		// Polygon of the component, null for a circle
+		PolygonBody* polygon;
+		// Index of the component in the polygon, zero for a circle
+		std::uint32_t componentIndex;
+	};
+	std::vector<Collider> _colliders;
+	std::vector<SweepAndPrune::Box> _boxes;
+	SweepAndPrune _broadPhase;
+
+	// Pairs of colliders, by entity and component index
+	struct ContactKey {
+		std::uint64_t a;
+		std::uint64_t b;
+
+		bool operator==(const ContactKey& other) const = default;
+	};
+	struct ContactKeyHash {
+		std::size_t operator()(const ContactKey& key) const;
+	};
+	// What the last frame found about a pair, to start from there. Bodies
+	// barely move between two frames, so GJK starts from the last search
+	// direction, and EPA from the last contact normal.
+	struct ContactCache {
+		Vector2f direction{1, 0};
+		// Normal of the contact, only if the pair collided
+		Vector2f normal{0, 0};
+		bool collided{false};
+		// Pairs not seen in an update are evicted at its end
+		std::uint64_t frame{0};
+	};
+	std::unordered_map<ContactKey, ContactCache, ContactKeyHash> _contactCache;
+	std::uint64_t _frame{0};
+
 	// List of 2D points formed by the difference of two shapes. This class
 	// makes it easy to store and pass around the difference and the original
-	// points together.
+	// points together. It is the simplex of GJK, so it has at most three
+	// points, stored inline.
 	class MinkowskyPolygon {
 	public:
+		static constexpr std::size_t capacity{3};
+
 		void pushBack(const Vector2f& A, const Vector2f& B);
 		void insert(std::size_t index, const Vector2f& A, const Vector2f& B);
 		void erase(std::size_t index);
@@ -44,7 +89,58 @@ private:
 		std::size_t size() const;
 
 	private:
-		std::vector<Vector2f> _pointsA, _pointsB;
+		std::array<Vector2f, capacity> _pointsA, _pointsB;
+		std::size_t _size{0};
+	};
+
+	// Polygon expanded by EPA around the origin, with a fixed capacity. The
+	// vertices form a circular linked list, so that inserting one does not move
+	// the others. An edge is named by its first vertex, and the edges are in a
+	// binary heap ordered by their distance to the origin, so that finding the
+	// closest one does not compute the distance of every edge again. Splitting
+	// an edge leaves it in the heap, and it is dropped when it reaches the top.
+	class Polytope {
+	public:
+		static constexpr std::size_t capacity{64};
+
+		explicit Polytope(const MinkowskyPolygon& simplex);
+		// Edge closest to the origin
+		std::size_t closestEdge();
+		// Distance to the origin of an edge, and its unit normal pointing
+		// away from the origin
+		float getDistance(std::size_t edge) const;
+		Vector2f getNormal(std::size_t edge) const;
+		// Vertex after the given vertex, that is the end of the edge
+		std::size_t next(std::size_t vertex) const;
+		// Inserts a vertex in the middle of an edge
+		void split(std::size_t edge, const Vector2f& A, const Vector2f& B);
+		// Inserts a point of the Minkowsky difference between the two vertices
+		// around it as seen from the origin, unless it is a vertex already
+		void insert(const Vector2f& A, const Vector2f& B);
+		bool isFull() const;
+		Vector2f getDifference(std::size_t index) const;
+		Vector2f getPointA(std::size_t index) const;
+		Vector2f getPointB(std::size_t index) const;
+
+	private:
+		struct HeapEntry {
+			float distance;
+			std::uint8_t start;
+			std::uint8_t end;
+		};
+
+		std::array<Vector2f, capacity> _pointsA, _pointsB;
+		std::array<std::uint8_t, capacity> _next;
+		// Distance and normal of each edge
+		std::array<float, capacity> _distances;
+		std::array<Vector2f, capacity> _normals;
+		std::size_t _size{0};
+		// Each split adds two edges, and the three edges of the simplex
+		// come first
+		std::array<HeapEntry, 2 * capacity> _heap;
+		std::size_t _heapSize{0};
+
+		void pushEdge(std::size_t edge);
 	};
 
 	// Information about the contact points or the distance between two bodies.
@@ -66,43 +162,58 @@ private:
 		float distance;
 	};
 
+	// The collision routines are templated on the support functions of the
+	// shapes, see SupportFunctions.hpp. They are only instantiated in
+	// CollisionSystem.cpp.
+	template <typename SupportA, typename SupportB>
 	void collideConvexes(EntityId idA, EntityId idB,
-			const SupportFunction& functionA, const SupportFunction& functionB,
-			Body& bodyA, Body& bodyB);
+			const SupportA& functionA, const SupportB& functionB,
+			BodyRef bodyA, BodyRef bodyB, ContactCache& cache);
 
 	// In the special case of two circle, the collision detection and response
 	// is much simpler, so we do both at once here.
 	void collideCircles(EntityId idA, EntityId idB,
 			const CircleBody& circleA, const CircleBody& circleB,
-			Body& bodyA, Body& bodyB);
+			BodyRef bodyA, BodyRef bodyB);
 
+	template <typename SupportB>
 	void collideCircleAndConvex(EntityId idA, EntityId idB,
-			const CircleBody& circleA, const SupportFunction& functionB,
-			Body& bodyA, Body& bodyB);
+			const CircleBody& circleA, const SupportB& functionB,
+			BodyRef bodyA, BodyRef bodyB, ContactCache& cache);
 
 	// Collision response between arbitrary bodies.
 	void collisionResponse(EntityId idA, EntityId idB,
-			Body& bodyA, Body& bodyB, const ContactInfo& contactInfo);
+			BodyRef bodyA, BodyRef bodyB, const ContactInfo& contactInfo);
 
 	// The Gilbert–Johnson–Keerthi (GJK) algorithm detects collisions between
 	// two bodies, and returns the simplex in the Minkowsky difference that is
 	// closed to the origin (enclosing it if there is a collision), along with a
-	// boolean indicating if there is collision.
+	// boolean indicating if there is collision. The search starts from the
+	// given direction, which is then set to the last search direction.
+	template <typename SupportA, typename SupportB>
 	std::pair<bool, MinkowskyPolygon> collisionGJK(
-			const SupportFunction& functionA, const SupportFunction& functionB);
+			const SupportA& functionA, const SupportB& functionB, Vector2f& direction);
 
 	// The GJK algorithm adapted to find the distance between two noncolliding
 	// convex bodies. It starts off with the simplex generated by collision GJK.
-	ContactInfo distanceGJK(const SupportFunction& functionA,
-			const SupportFunction& functionB, MinkowskyPolygon polygon);
+	template <typename SupportA, typename SupportB>
+	ContactInfo distanceGJK(const SupportA& functionA,
+			const SupportB& functionB, MinkowskyPolygon polygon);
 
 	// The Expanding Polytope Algorithm computes the collision vector, which is
 	// the minimum vector that would stop the shapes from overlapping. It takes
 	// as input the simplex enclosing the origin computed by collision GJK.
-	ContactInfo EPA(const SupportFunction& functionA,
-			const SupportFunction& functionB, MinkowskyPolygon polygon);
-
-	ContactInfo createContactInfo(const MinkowskyPolygon& simplex,
+	// With warmStart, the given normal, such as the one of the last frame,
+	// adds the support points around its direction to the simplex first. It
+	// is then set to the normal of the closest edge.
+	template <typename SupportA, typename SupportB>
+	ContactInfo EPA(const SupportA& functionA, const SupportB& functionB,
+			MinkowskyPolygon simplex, Vector2f& normal, bool warmStart);
+
+	// Contact info from the edge between the vertices i and j of a simplex or
+	// a polytope
+	template <typename Polygon>
+	ContactInfo createContactInfo(const Polygon& polygon,
 			std::size_t i, std::size_t j, bool inside);
 
 	// Updates the simplex for collision GJK. It just dispatches to the line or
@@ -14,12 +14,13 @@ namespace sf {
     class ConvexShape;
 }
 class Scene;
+class PhysicsSystem;
 
 
 class LightSystem {
 public:
     LightSystem(Scene& scene, const sf::RenderTarget& renderTarget, sf::Shader& shader);
-    void update();
+    void update(const PhysicsSystem& physics);
 
 private:
     Scene& _scene;
@@ -28,7 +29,10 @@ private:
     sf::RenderTexture _renderTexture;
     Vector2f _screenSize;
 
-    std::vector<sf::ConvexShape> computeShadowShapes();
+    std::vector<sf::ConvexShape> computeShadowShapes(const PhysicsSystem& physics);
+    void addShadowShape(const std::vector<Vector2f>& shadowPoints,
+            const Vector2f& lightSource, const std::array<Vector2f, 4>& view,
+            std::vector<sf::ConvexShape>& shadowShapes);
     std::vector<Vector2f> computeShadowGeometry(const std::vector<Vector2f>& shadowVertices,
             const Vector2f& lightSource, const std::array<Vector2f, 4>& view);
 };
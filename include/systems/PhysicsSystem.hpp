@@ -2,37 +2,187 @@
 #define PHYSICSSYSTEM_HPP
 
 #include <cstdint>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <vector>
 #include <SFML/System/Time.hpp>
 #include <vector.hpp>
+#include <BarnesHutTree.hpp>
+#include <GravityKernel.hpp>
+#include <Integrator.hpp>
+#include <SnapshotBuffer.hpp>
+#include <ThreadPool.hpp>
 
 // Forward declarations
 class Scene;
+struct PhysicsSettings;
+struct PolygonBody;
 typedef std::uint32_t EntityId;
 
 
 class PhysicsSystem {
 public:
-	PhysicsSystem(Scene& scene);
+	PhysicsSystem(Scene& scene, const PhysicsSettings& settings);
     void update(sf::Time dt);
 	void updateSteps(int steps);
 	void setTimeScale(float timeScale);
 	long long int getStepCounter() const;
 	sf::Time getElapsedTime() const;
 
+	/// Fraction of a step elapsed since the last step. Rendering uses it to
+	/// interpolate between the state before the last step and the current
+	/// one, so that the motion is smooth at any frame rate.
+	float getInterpolationFactor() const;
+	/// Position and rotation of a body to render
+	Vector2f interpolatePosition(EntityId id, const Vector2f& position) const;
+	float interpolateRotation(EntityId id, float rotation) const;
+	/// Bodies changed after this tick of the scene are interpolated, so
+	/// rendering has to update them at each frame until the next step.
+	std::uint64_t getInterpolationTick() const;
+	/// Gravitational constant in the units of the scene
+	float getGravitationalConstant() const;
+	/// Whether the given body pulls the other bodies, because it has the
+	/// GravitySource component or it is heavier than the mass threshold
+	bool isGravitySource(EntityId id, float mass) const;
+
 private:
 	Scene& _scene;
+	const PhysicsSettings& _settings;
+	// Created again when the integrator of the settings changes
+	std::unique_ptr<Integrator> _integrator;
+	IntegratorType _integratorType{IntegratorType::RungeKutta4};
+	// Rebuilt at each force evaluation from the sources when the Barnes-Hut
+	// solver is selected
+	BarnesHutTree _tree;
+	// Positions and masses of the gravity sources, packed at each step so
+	// that only them are summed
+	std::vector<Vector2f> _sourcePositions;
+	std::vector<float> _sourceMasses;
+	// Squared Plummer softening of each source
+	std::vector<float> _sourceSoftenings;
+	// Index in the body storage of each source
+	std::vector<std::size_t> _sourceBodies;
+	// Sources with a PolygonBody: their index in the source arrays, their
+	// shape and their rotation at the start of the step
+	std::vector<std::size_t> _extendedSources;
+	std::vector<const PolygonBody*> _extendedShapes;
+	std::vector<float> _extendedRotations;
+	// Index in the source arrays of each body of the body storage, so that a
+	// source does not attract itself
+	std::vector<std::size_t> _sourceSlots;
+	// Kernel of the direct solver, selected for the CPU at construction
+	GravityKernel _gravityKernel{bestGravityKernel()};
+	static constexpr std::size_t _notASource{std::numeric_limits<std::size_t>::max()};
+	ThreadPool _threadPool;
+	// Below this number of bodies, a step runs on the calling thread only
+	static constexpr std::size_t _grain{64};
+	// Block timesteps, per body of the body storage. The entities detect the
+	// bodies that moved in the storage since the last step, and the slot of
+	// each entity index in the last step finds their state again.
+	std::vector<EntityId> _blockEntities;
+	std::vector<std::size_t> _blockSlots;
+	std::vector<unsigned> _blockLevels;
+	std::vector<Vector2f> _blockAccelerations;
+	std::vector<Vector2f> _previousAccelerations;
+	// Bodies of the body storage needing new forces
+	std::vector<std::size_t> _activeBodies;
+	// Close encounters: the index in the body storage of each body advanced
+	// on a conic, the index in the source arrays of its primary, and its
+	// state relative to the primary during the step
+	std::vector<std::size_t> _encounterBodies;
+	std::vector<std::size_t> _encounterSources;
+	std::vector<Vector2d> _encounterPositions;
+	std::vector<Vector2d> _encounterVelocities;
+	// On-rails propagation: the index in the body storage of the primary of
+	// each body, before and after the propagation, and the initial state
+	std::vector<std::size_t> _primaries;
+	std::vector<std::size_t> _newPrimaries;
+	std::vector<std::size_t> _railsOrder;
+	std::vector<Vector2f> _railsPositions;
+	std::vector<Vector2f> _railsVelocities;
+	// Keyframes to rewind time, and the changes of the bodies made between
+	// the steps
+	SnapshotBuffer _snapshots;
+	// State of each step simulated forward from a keyframe by the last
+	// rewind, so that the next frames of the rewind only restore it
+	SnapshotBuffer _replay;
+	// Bodies changed after this tick were changed outside of the steps. It
+	// starts at the tick of the construction, so that the bodies loaded with
+	// the scene are in the first keyframe only, not in the changes.
+	std::uint64_t _historyTick;
+	// State of the bodies before the last step, for render interpolation,
+	// and the index in it of each entity index
+	std::vector<Vector2f> _previousPositions;
+	std::vector<float> _previousRotations;
+	std::vector<EntityId> _previousEntities;
+	std::vector<std::size_t> _previousSlots;
+	std::uint64_t _interpolationTick{0};
 	float _timeScale{1};
-	sf::Time _timeStep{sf::seconds(0.02f)};
+	sf::Time _timeStep;
 	sf::Time _currentStep{sf::seconds(0)};
 	// Might go back in time, so step counter is signed, and at least 64 bits.
 	long long int _stepCounter{0};
 	// Convert G from meters^3 kg/s^2 to px^3 kg/s^2
 	const float _gravitationalConstant{6.67430e-11f * 36.f * 36.f * 36.f};
 
-	/// Computes the acceleration field at a point given the other bodies.
-	/// The body with given id is ignored from the computation
-	Vector2f computeAcceleration(const Vector2f& position, EntityId id) const;
+	/// Computes the acceleration field at a point given the gravity sources.
+	/// The body at the given index in the body storage is ignored from the
+	/// computation
+	Vector2f computeAcceleration(const Vector2f& position, std::size_t index) const;
+	/// Computes the acceleration field at a point given the gravity sources,
+	/// without the source at the given index in the source arrays
+	Vector2f computeField(const Vector2f& position, std::size_t source) const;
+	/// Difference between the field of the extended sources and the field of
+	/// their point mass at a point, without the source at the given index
+	Vector2f computeExtendedField(const Vector2f& position, std::size_t source) const;
+	/// Computes the accelerations of all the bodies, in the order of the body
+	/// storage, when they are at the given positions
+	void computeAccelerations(const std::vector<Vector2f>& positions,
+		std::vector<Vector2f>& accelerations);
+	/// Same as above, but only for the bodies at the given indices
+	void computeAccelerations(const std::vector<std::size_t>& indices,
+		const std::vector<Vector2f>& positions, std::vector<Vector2f>& accelerations);
+	/// Moves the sources at the given positions of the bodies
+	void updateSources(const std::vector<Vector2f>& positions);
+	/// Packs the bodies that have the GravitySource component or that are
+	/// heavier than the mass threshold of the settings.
+	void gatherSources();
 	void updateStep(bool backwards);
+	/// Finds the bodies in a close encounter with a source, and moves them in
+	/// the frame of the source with the first half kick of the perturbations
+	void startEncounters(float dt);
+	/// Advances the bodies in a close encounter on their conic for dt, once
+	/// the sources are advanced, and applies the last half kick
+	void finishEncounters(float dt);
+	/// Acceleration of a body relative to its primary due to the other sources
+	Vector2f computePerturbation(const Vector2f& position, std::size_t source) const;
+	/// Advances the bodies from the step counter from to the step counter to
+	/// with block timesteps
+	void updateBlocks(long long int from, long long int to, float dt);
+	/// Advances all the bodies by the given number of steps at once, each one
+	/// on its conic around its primary. Returns false without changing
+	/// anything if a body thrusts, touches its primary, or changes of primary.
+	bool propagateOnRails(long long int steps);
+	/// The primary of a body is the heavier source pulling it the most, or
+	/// _notASource if there is none
+	void findPrimaries(const std::vector<Vector2f>& positions,
+		std::vector<std::size_t>& primaries) const;
+	bool isThrusting(EntityId id) const;
+	/// Records a keyframe if the step counter is at the keyframe interval,
+	/// and the bodies changed since the last step
+	void recordHistory();
+	/// Goes back to the given step from the latest keyframe before it,
+	/// replaying the recorded changes of the bodies. Returns false without
+	/// changing anything if there is no such keyframe.
+	bool rewind(long long int step);
+	/// Saves the current state as the state before the next step
+	void saveRenderState();
+	/// Finds the index of a body in the saved state, by entity
+	bool findRenderState(EntityId id, std::size_t& index) const;
+	/// Moves the world vertices of the polygon bodies to their state after
+	/// the last step, for the collisions and the lighting of this frame
+	void updateWorldVertices();
 };
 
 #endif // PHYSICSSYSTEM_HPP
@@ -1,6 +1,7 @@
 #ifndef RENDERSYSTEM_HPP
 #define RENDERSYSTEM_HPP
 
+#include <cstdint>
 #include <SFML/Graphics/Drawable.hpp>
 #include <Scene.hpp>
 #include <BlackBodyTable.hpp>
@@ -9,17 +10,20 @@
 namespace sf {
     class Time;
 }
+class PhysicsSystem;
 
 
 class RenderSystem : public sf::Drawable {
 public:
     RenderSystem(Scene& scene);
     virtual void draw(sf::RenderTarget& target, sf::RenderStates states) const override;
-    void update();
+    void update(const PhysicsSystem& physics);
 
 private:
     Scene& _scene;
     BlackBodyTable _table;
+    // Tick of the last update, see Scene::advanceTick
+    std::uint64_t _lastTick{0};
 };
 
 #endif // RENDERSYSTEM_HPP
@@ -1,12 +1,15 @@
 #ifndef THERMODYNAMICSSYSTEM_HPP
 #define THERMODYNAMICSSYSTEM_HPP
 
+#include <cstdint>
+
 // Forward declarations
 namespace sf {
     class Time;
 }
 class Scene;
 struct Event;
+typedef std::uint32_t EntityId;
 
 class ThermodynamicsSystem {
 public:
@@ -14,7 +17,15 @@ public:
     void update(sf::Time dt);
 
 private:
+    // Temperature change under which the colors of the graphics barely
+    // change, so that slowly cooling bodies are not redrawn every frame
+    static constexpr float changeThreshold{0.5f};
     Scene& _scene;
+
+    // Marks a temperature component changed once its cells changed by more
+    // than the threshold since the last mark
+    template <typename T>
+    void markChanged(EntityId id, T& temperature, float maxChange);
 };
 
 #endif // THERMODYNAMICSSYSTEM_HPP
@@ -91,6 +91,26 @@ Vector2<T> rotate(const Vector2<T>& v, T angle) {
 	        v.x * std::sin(angle) + v.y * std::cos(angle)};
 }
 
+// Rotation matrix of an angle. The cosine and sine are computed once, to
+// rotate many vectors by the same angle.
+template <std::floating_point T>
+struct Rotation {
+	T cos{1};
+	T sin{0};
+
+	Rotation() = default;
+	explicit Rotation(T angle):
+		cos{std::cos(angle)},
+		sin{std::sin(angle)} {
+	}
+};
+
+template <std::floating_point T>
+constexpr Vector2<T> rotate(const Vector2<T>& v, const Rotation<T>& rotation) {
+	return {v.x * rotation.cos - v.y * rotation.sin,
+	        v.x * rotation.sin + v.y * rotation.cos};
+}
+
 // Computes the intersection P between the line AB and CD. The result is the
 // barycentric coordinate u, v of P on the line AB and CD. It is such that
 // P = A + u * (B - A) = C + v * (D - C). So when 0 < u < 1, P is located
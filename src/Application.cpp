@@ -82,7 +82,9 @@ void Application::registerStateBuilders() {
             _soundBufferManager, _settings);
     _stack.registerStateBuilder<LoadGameState>(_stack);
     _stack.registerStateBuilder<MainMenuState>(_stack, _tguiTextureManager);
-    _stack.registerStateBuilder<MapState, Scene&>(_stack, _tguiTextureManager, _settings);
+    _stack.registerStateBuilder<MapState, Scene&, const PhysicsSystem&,
+            const TrajectoryPredictor&>(_stack,
+            _tguiTextureManager, _settings);
     _stack.registerStateBuilder<PauseState, const SceneSerializer&>(_stack);
     _stack.registerStateBuilder<SaveGameState, const SceneSerializer&>(_stack);
     _stack.registerStateBuilder<SettingsState>(_stack, _settings, _window);
@@ -0,0 +1,167 @@
+#include <array>
+#include <cmath>
+#include <algorithm>
+#include <BarnesHutTree.hpp>
+
+void BarnesHutTree::build(const std::vector<Vector2f>& positions, const std::vector<float>& masses,
+        const std::vector<float>& softenings) {
+    _nodes.clear();
+    _bodies.resize(positions.size());
+    if (positions.empty()) {
+        return;
+    }
+
+    // The root is the bounding square of the bodies
+    Vector2f min{positions.front()};
+    Vector2f max{positions.front()};
+    for (const Vector2f& position : positions) {
+        min.x = std::min(min.x, position.x);
+        min.y = std::min(min.y, position.y);
+        max.x = std::max(max.x, position.x);
+        max.y = std::max(max.y, position.y);
+    }
+    const float halfSize{std::max({max.x - min.x, max.y - min.y, 1.f}) / 2.f};
+    _nodes.push_back({(min + max) / 2.f, halfSize});
+
+    for (std::uint32_t i{0}; i < positions.size(); ++i) {
+        _bodies[i] = {positions[i], masses[i], softenings[i], none};
+        insert(i);
+    }
+
+    // Leaves hold the weighted sums of the positions and softenings of their
+    // bodies. Sum them up the tree, children being after their parent, and
+    // then normalize.
+    for (std::size_t i{_nodes.size()}; i-- > 0;) {
+        Node& node{_nodes[i]};
+        if (node.firstChild != none) {
+            node.mass = 0;
+            node.centerOfMass = {0, 0};
+            node.softening = 0;
+            for (std::uint32_t child{node.firstChild}; child < node.firstChild + 4; ++child) {
+                node.mass += _nodes[child].mass;
+                node.centerOfMass += _nodes[child].centerOfMass;
+                node.softening += _nodes[child].softening;
+            }
+        }
+    }
+    for (Node& node : _nodes) {
+        if (node.mass > 0) {
+            node.centerOfMass /= node.mass;
+            node.softening /= node.mass;
+        }
+        node.offset = norm(node.centerOfMass - node.center);
+    }
+}
+
+Vector2f BarnesHutTree::field(const Vector2f& position, std::size_t exclude, float theta) const {
+    Vector2f res{0, 0};
+    if (_nodes.empty()) {
+        return res;
+    }
+    // Each visited internal node replaces itself with its four children, so
+    // this bounds the size of the stack.
+    std::array<std::uint32_t, 3 * (maxDepth + 1) + 1> stack;
+    std::size_t top{0};
+    stack[top++] = 0;
+
+    while (top > 0) {
+        const std::uint32_t index{stack[--top]};
+        const Node& node{_nodes[index]};
+        float mass{node.mass};
+        Vector2f centerOfMass{node.centerOfMass};
+        float softening{node.softening};
+        if (node.firstChild == none) {
+            if (node.body == none) {
+                continue;
+            }
+            if (exclude < _bodies.size() and _bodies[exclude].leaf == index) {
+                // Remove the excluded body from its leaf. The leaf usually
+                // contains only this body.
+                const BodyEntry& self{_bodies[exclude]};
+                const float otherMass{mass - self.mass};
+                if (otherMass <= 0) {
+                    continue;
+                }
+                centerOfMass = (centerOfMass * mass - self.position * self.mass) / otherMass;
+                softening = std::max(0.f, (softening * mass - self.softening * self.mass) / otherMass);
+                mass = otherMass;
+            }
+        } else {
+            // Open the node if it is seen under an angle larger than theta, or
+            // if it contains the evaluation point, because then it may also
+            // contain the excluded body. The distance is reduced by the offset
+            // of the center of mass, since the bodies can be closer than it
+            // when it is near a side of the node (Barnes 1994).
+            const float size{2 * node.halfSize};
+            const float dist{norm(centerOfMass - position) - node.offset};
+            const bool inside{std::abs(position.x - node.center.x) <= node.halfSize
+                and std::abs(position.y - node.center.y) <= node.halfSize};
+            if (inside or dist <= 0 or size >= theta * dist) {
+                for (std::uint32_t child{node.firstChild}; child < node.firstChild + 4; ++child) {
+                    stack[top++] = child;
+                }
+                continue;
+            }
+        }
+        const Vector2f dx{centerOfMass - position};
+        const float dist{std::sqrt(norm2(dx) + softening)};
+        res += mass * dx / (dist * dist * dist);
+    }
+    return res;
+}
+
+void BarnesHutTree::insert(std::uint32_t body) {
+    const Vector2f position{_bodies[body].position};
+    std::uint32_t node{0};
+    unsigned depth{0};
+    while (true) {
+        if (_nodes[node].firstChild != none) {
+            node = childContaining(node, position);
+            ++depth;
+        } else if (_nodes[node].body == none) {
+            placeInLeaf(node, body);
+            return;
+        } else if (depth == maxDepth) {
+            // Merge with the bodies already in the leaf
+            _nodes[node].mass += _bodies[body].mass;
+            _nodes[node].centerOfMass += _bodies[body].mass * position;
+            _nodes[node].softening += _bodies[body].mass * _bodies[body].softening;
+            _bodies[body].leaf = node;
+            return;
+        } else {
+            // Move the body of the leaf in a child, and continue from the new
+            // internal node.
+            const std::uint32_t other{_nodes[node].body};
+            _nodes[node].body = none;
+            subdivide(node);
+            placeInLeaf(childContaining(node, _bodies[other].position), other);
+        }
+    }
+}
+
+void BarnesHutTree::placeInLeaf(std::uint32_t node, std::uint32_t body) {
+    _nodes[node].body = body;
+    _nodes[node].mass = _bodies[body].mass;
+    _nodes[node].centerOfMass = _bodies[body].mass * _bodies[body].position;
+    _nodes[node].softening = _bodies[body].mass * _bodies[body].softening;
+    _bodies[body].leaf = node;
+}
+
+void BarnesHutTree::subdivide(std::uint32_t node) {
+    const Vector2f center{_nodes[node].center};
+    const float halfSize{_nodes[node].halfSize / 2.f};
+    _nodes[node].firstChild = static_cast<std::uint32_t>(_nodes.size());
+    // Children are ordered so that bit 0 is the x half and bit 1 the y half,
+    // see childContaining.
+    for (unsigned quadrant{0}; quadrant < 4; ++quadrant) {
+        const Vector2f offset{quadrant & 1 ? halfSize : -halfSize, quadrant & 2 ? halfSize : -halfSize};
+        _nodes.push_back({center + offset, halfSize});
+    }
+}
+
+std::uint32_t BarnesHutTree::childContaining(std::uint32_t node, const Vector2f& position) const {
+    const Node& parent{_nodes[node]};
+    return parent.firstChild
+        + (position.x >= parent.center.x ? 1u : 0u)
+        + (position.y >= parent.center.y ? 2u : 0u);
+}
@@ -0,0 +1,140 @@
+#include <cmath>
+#include <GravityKernel.hpp>
+
+// The vectorized kernels use the GCC/Clang target attributes, so that the rest
+// of the program does not need to be compiled for AVX2.
+#if (defined(__GNUC__) or defined(__clang__)) and (defined(__x86_64__) or defined(__i386__))
+#define GRAVITY_KERNEL_X86
+#include <immintrin.h>
+#endif
+
+// The kernels read the positions as interleaved x and y floats
+static_assert(sizeof(Vector2f) == 2 * sizeof(float));
+
+namespace {
+    Vector2f scalarField(const Vector2f* positions, const float* masses,
+            const float* softenings, std::size_t count, const Vector2f& position) {
+        Vector2f res{0, 0};
+        for (std::size_t j{0}; j < count; ++j) {
+            const Vector2f dx{positions[j] - position};
+            const float invDist{1.f / std::sqrt(dx.x * dx.x + dx.y * dx.y + softenings[j])};
+            res += masses[j] * invDist * invDist * invDist * dx;
+        }
+        return res;
+    }
+
+#ifdef GRAVITY_KERNEL_X86
+    // Four sources starting at positions
+    __attribute__((target("sse2")))
+    void sseStep(const float* positions, const float* masses, const float* softenings,
+            __m128 px, __m128 py, __m128& ax, __m128& ay) {
+        const __m128 a{_mm_loadu_ps(positions)};
+        const __m128 b{_mm_loadu_ps(positions + 4)};
+        const __m128 dx{_mm_sub_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)), px)};
+        const __m128 dy{_mm_sub_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)), py)};
+        const __m128 r2{_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)),
+            _mm_loadu_ps(softenings))};
+        // Newton step on 1/sqrt(r2): y = y * (1.5 - 0.5 * r2 * y * y)
+        __m128 invDist{_mm_rsqrt_ps(r2)};
+        invDist = _mm_mul_ps(invDist, _mm_sub_ps(_mm_set1_ps(1.5f),
+            _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(0.5f), r2), _mm_mul_ps(invDist, invDist))));
+        const __m128 weight{_mm_mul_ps(_mm_loadu_ps(masses),
+            _mm_mul_ps(invDist, _mm_mul_ps(invDist, invDist)))};
+        ax = _mm_add_ps(ax, _mm_mul_ps(weight, dx));
+        ay = _mm_add_ps(ay, _mm_mul_ps(weight, dy));
+    }
+
+    __attribute__((target("sse2")))
+    Vector2f sseField(const Vector2f* positions, const float* masses,
+            const float* softenings, std::size_t count, const Vector2f& position) {
+        const float* xy{reinterpret_cast<const float*>(positions)};
+        const __m128 px{_mm_set1_ps(position.x)};
+        const __m128 py{_mm_set1_ps(position.y)};
+        __m128 ax{_mm_setzero_ps()};
+        __m128 ay{_mm_setzero_ps()};
+        std::size_t j{0};
+        // Eight sources per iteration, in two independent halves
+        for (; j + 8 <= count; j += 8) {
+            sseStep(xy + 2 * j, masses + j, softenings + j, px, py, ax, ay);
+            sseStep(xy + 2 * j + 8, masses + j + 4, softenings + j + 4, px, py, ax, ay);
+        }
+        alignas(16) float sx[4];
+        alignas(16) float sy[4];
+        _mm_store_ps(sx, ax);
+        _mm_store_ps(sy, ay);
+        const Vector2f res{sx[0] + sx[1] + sx[2] + sx[3], sy[0] + sy[1] + sy[2] + sy[3]};
+        return res + scalarField(positions + j, masses + j, softenings + j, count - j, position);
+    }
+
+    __attribute__((target("avx2,fma")))
+    Vector2f avx2Field(const Vector2f* positions, const float* masses,
+            const float* softenings, std::size_t count, const Vector2f& position) {
+        const float* xy{reinterpret_cast<const float*>(positions)};
+        const __m256 px{_mm256_set1_ps(position.x)};
+        const __m256 py{_mm256_set1_ps(position.y)};
+        const __m256 half{_mm256_set1_ps(0.5f)};
+        const __m256 threeHalves{_mm256_set1_ps(1.5f)};
+        // The shuffles below deinterleave the sources in the order
+        // 0 1 4 5 2 3 6 7, so the masses and softenings are permuted the same
+        // way.
+        const __m256i massOrder{_mm256_setr_epi32(0, 1, 4, 5, 2, 3, 6, 7)};
+        __m256 ax{_mm256_setzero_ps()};
+        __m256 ay{_mm256_setzero_ps()};
+        std::size_t j{0};
+        for (; j + 8 <= count; j += 8) {
+            const __m256 a{_mm256_loadu_ps(xy + 2 * j)};
+            const __m256 b{_mm256_loadu_ps(xy + 2 * j + 8)};
+            const __m256 dx{_mm256_sub_ps(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)), px)};
+            const __m256 dy{_mm256_sub_ps(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)), py)};
+            const __m256 mass{_mm256_permutevar8x32_ps(_mm256_loadu_ps(masses + j), massOrder)};
+            const __m256 softening{_mm256_permutevar8x32_ps(_mm256_loadu_ps(softenings + j), massOrder)};
+            const __m256 r2{_mm256_fmadd_ps(dx, dx, _mm256_fmadd_ps(dy, dy, softening))};
+            __m256 invDist{_mm256_rsqrt_ps(r2)};
+            invDist = _mm256_mul_ps(invDist, _mm256_fnmadd_ps(_mm256_mul_ps(half, r2),
+                _mm256_mul_ps(invDist, invDist), threeHalves));
+            const __m256 weight{_mm256_mul_ps(mass, _mm256_mul_ps(invDist, _mm256_mul_ps(invDist, invDist)))};
+            ax = _mm256_fmadd_ps(weight, dx, ax);
+            ay = _mm256_fmadd_ps(weight, dy, ay);
+        }
+        alignas(32) float sx[8];
+        alignas(32) float sy[8];
+        _mm256_store_ps(sx, ax);
+        _mm256_store_ps(sy, ay);
+        Vector2f res{0, 0};
+        for (int k{0}; k < 8; ++k) {
+            res += Vector2f(sx[k], sy[k]);
+        }
+        return res + scalarField(positions + j, masses + j, softenings + j, count - j, position);
+    }
+#endif
+}
+
+std::vector<std::pair<std::string, GravityKernel>> availableGravityKernels() {
+    std::vector<std::pair<std::string, GravityKernel>> res{{"scalar", &scalarField}};
+#ifdef GRAVITY_KERNEL_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse2")) {
+        res.emplace_back("sse", &sseField);
+    }
+    if (__builtin_cpu_supports("avx2") and __builtin_cpu_supports("fma")) {
+        res.emplace_back("avx2", &avx2Field);
+    }
+#endif
+    return res;
+}
+
+GravityKernel bestGravityKernel() {
+    return availableGravityKernels().back().second;
+}
+
+Vector2f gravityField(GravityKernel kernel, const std::vector<Vector2f>& positions,
+        const std::vector<float>& masses, const std::vector<float>& softenings,
+        const Vector2f& position, std::size_t exclude) {
+    const std::size_t n{positions.size()};
+    if (exclude >= n) {
+        return kernel(positions.data(), masses.data(), softenings.data(), n, position);
+    }
+    return kernel(positions.data(), masses.data(), softenings.data(), exclude, position)
+        + kernel(positions.data() + exclude + 1, masses.data() + exclude + 1,
+            softenings.data() + exclude + 1, n - exclude - 1, position);
+}
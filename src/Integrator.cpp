@@ -0,0 +1,110 @@
+#include <array>
+#include <cmath>
+#include <cassert>
+#include <Integrator.hpp>
+
+namespace {
+    void drift(std::vector<Vector2f>& positions, const std::vector<Vector2f>& velocities, float dt) {
+        for (std::size_t i{0}; i < positions.size(); ++i) {
+            positions[i] += velocities[i] * dt;
+        }
+    }
+
+    void kick(std::vector<Vector2f>& velocities, const std::vector<Vector2f>& accelerations, float dt) {
+        for (std::size_t i{0}; i < velocities.size(); ++i) {
+            velocities[i] += accelerations[i] * dt;
+        }
+    }
+
+    // Sequence of drifts and kicks, starting and ending with a drift. Each
+    // coefficient is symmetric around the middle, so the step with -dt undoes
+    // the step with dt, up to rounding.
+    template <std::size_t Kicks>
+    class SplittingIntegrator : public Integrator {
+    public:
+        SplittingIntegrator(const std::array<float, Kicks + 1>& drifts,
+                const std::array<float, Kicks>& kicks):
+            _drifts{drifts},
+            _kicks{kicks} {
+        }
+
+        void step(std::vector<Vector2f>& positions, std::vector<Vector2f>& velocities,
+                float dt, const AccelerationFunction& acceleration) override {
+            _accelerations.resize(positions.size());
+            for (std::size_t k{0}; k < Kicks; ++k) {
+                drift(positions, velocities, _drifts[k] * dt);
+                acceleration(positions, _accelerations);
+                kick(velocities, _accelerations, _kicks[k] * dt);
+            }
+            drift(positions, velocities, _drifts[Kicks] * dt);
+        }
+
+    private:
+        const std::array<float, Kicks + 1> _drifts;
+        const std::array<float, Kicks> _kicks;
+        std::vector<Vector2f> _accelerations;
+    };
+
+    class RungeKutta4Integrator : public Integrator {
+    public:
+        void step(std::vector<Vector2f>& positions, std::vector<Vector2f>& velocities,
+                float dt, const AccelerationFunction& acceleration) override {
+            const std::size_t n{positions.size()};
+            _x0 = positions;
+            _v0 = velocities;
+            _a.resize(n);
+
+            // Stage weights of dx and dv, and offset of the next stage
+            const std::array<float, 4> weights{1.f / 6.f, 2.f / 6.f, 2.f / 6.f, 1.f / 6.f};
+            const std::array<float, 3> offsets{0.5f, 0.5f, 1.f};
+            _x = _x0;
+            _v = _v0;
+            _dx.assign(n, {0, 0});
+            _dv.assign(n, {0, 0});
+            for (std::size_t stage{0}; stage < 4; ++stage) {
+                acceleration(_x, _a);
+                for (std::size_t i{0}; i < n; ++i) {
+                    // The derivative of x is v, and the one of v is a
+                    _dx[i] += weights[stage] * _v[i];
+                    _dv[i] += weights[stage] * _a[i];
+                }
+                if (stage < 3) {
+                    for (std::size_t i{0}; i < n; ++i) {
+                        _x[i] = _x0[i] + offsets[stage] * dt * _v[i];
+                        _v[i] = _v0[i] + offsets[stage] * dt * _a[i];
+                    }
+                }
+            }
+            for (std::size_t i{0}; i < n; ++i) {
+                positions[i] = _x0[i] + dt * _dx[i];
+                velocities[i] = _v0[i] + dt * _dv[i];
+            }
+        }
+
+    private:
+        std::vector<Vector2f> _x0, _v0, _x, _v, _a, _dx, _dv;
+    };
+}
+
+std::unique_ptr<Integrator> createIntegrator(IntegratorType type) {
+    switch (type) {
+        case IntegratorType::Leapfrog:
+            return std::make_unique<SplittingIntegrator<1>>(
+                std::array<float, 2>{0.5f, 0.5f}, std::array<float, 1>{1.f});
+        case IntegratorType::Yoshida4: {
+            // Yoshida (1990), with the drifts of consecutive leapfrog steps
+            // merged
+            const double cbrt2{std::cbrt(2.)};
+            const float w1{static_cast<float>(1. / (2. - cbrt2))};
+            const float w0{static_cast<float>(-cbrt2 / (2. - cbrt2))};
+            return std::make_unique<SplittingIntegrator<3>>(
+                std::array<float, 4>{w1 / 2.f, (w0 + w1) / 2.f, (w0 + w1) / 2.f, w1 / 2.f},
+                std::array<float, 3>{w1, w0, w1});
+        }
+        case IntegratorType::RungeKutta4:
+            return std::make_unique<RungeKutta4Integrator>();
+        default:
+            assert(false);
+            return nullptr;
+    }
+}
@@ -0,0 +1,88 @@
+#include <cmath>
+#include <Kepler.hpp>
+
+namespace {
+    // Stumpff functions, with their series near zero where the closed forms
+    // lose all precision
+    double stumpffC(double z) {
+        if (z > 1e-6) {
+            return (1. - std::cos(std::sqrt(z))) / z;
+        } else if (z < -1e-6) {
+            return (std::cosh(std::sqrt(-z)) - 1.) / -z;
+        }
+        return 1. / 2. - z / 24. + z * z / 720.;
+    }
+
+    double stumpffS(double z) {
+        if (z > 1e-6) {
+            const double s{std::sqrt(z)};
+            return (s - std::sin(s)) / (s * s * s);
+        } else if (z < -1e-6) {
+            const double s{std::sqrt(-z)};
+            return (std::sinh(s) - s) / (s * s * s);
+        }
+        return 1. / 6. - z / 120. + z * z / 5040.;
+    }
+}
+
+void propagateKepler(Vector2d& position, Vector2d& velocity, double mu, double dt) {
+    const double r0{norm(position)};
+    const double sqrtMu{std::sqrt(mu)};
+    const double rv0{dot(position, velocity)};
+    // Inverse of the semi-major axis, negative for a hyperbola
+    const double alpha{2. / r0 - dot(velocity, velocity) / mu};
+
+    // Initial guess of the universal anomaly, see Vallado, Fundamentals of
+    // Astrodynamics and Applications, algorithm 8
+    double chi;
+    if (alpha > 1e-12) {
+        // Whole periods bring the body back where it was, and removing them
+        // keeps the anomaly small enough for Newton's method
+        const double period{2. * std::acos(-1.) / (sqrtMu * alpha * std::sqrt(alpha))};
+        dt = std::remainder(dt, period);
+        chi = sqrtMu * alpha * dt;
+    } else if (alpha < -1e-12) {
+        const double a{1. / alpha};
+        const double sign{dt < 0 ? -1. : 1.};
+        chi = sign * std::sqrt(-a) * std::log((-2. * mu * alpha * dt)
+            / (rv0 + sign * std::sqrt(-mu * a) * (1. - r0 * alpha)));
+    } else {
+        chi = sqrtMu * dt / r0;
+    }
+
+    // Newton's method on the universal Kepler equation
+    for (int i{0}; i < 50; ++i) {
+        const double z{alpha * chi * chi};
+        const double c{stumpffC(z)};
+        const double s{stumpffS(z)};
+        const double f{rv0 / sqrtMu * chi * chi * c + (1. - alpha * r0) * chi * chi * chi * s
+            + r0 * chi - sqrtMu * dt};
+        const double df{rv0 / sqrtMu * chi * (1. - z * s) + (1. - alpha * r0) * chi * chi * c + r0};
+        const double delta{f / df};
+        chi -= delta;
+        if (std::abs(delta) <= 1e-12 * (1. + std::abs(chi))) {
+            break;
+        }
+    }
+
+    // Lagrange coefficients
+    const double z{alpha * chi * chi};
+    const double c{stumpffC(z)};
+    const double s{stumpffS(z)};
+    const double f{1. - chi * chi / r0 * c};
+    const double g{dt - chi * chi * chi * s / sqrtMu};
+    const Vector2d newPosition{f * position + g * velocity};
+    const double r{norm(newPosition)};
+    const double df{sqrtMu / (r * r0) * (z * chi * s - chi)};
+    const double dg{1. - chi * chi / r * c};
+    velocity = df * position + dg * velocity;
+    position = newPosition;
+}
+
+double periapsis(const Vector2d& position, const Vector2d& velocity, double mu) {
+    const double r{norm(position)};
+    const double h{cross(position, velocity)};
+    const Vector2d eccentricity{((dot(velocity, velocity) - mu / r) * position
+        - dot(position, velocity) * velocity) / mu};
+    return h * h / mu / (1. + norm(eccentricity));
+}
@@ -0,0 +1,62 @@
+#include <Multipole.hpp>
+#include <polygon.hpp>
+
+Multipole polygonMultipole(const ConvexPolygon& polygon, float density) {
+    const auto [area, center] = polygon.areaAndCenterOfMass();
+    const std::array<float, 3> moments{polygon.secondMoments()};
+    return {center, area * density,
+        density * (2.f * moments[0] - moments[2]),
+        density * 3.f * moments[1],
+        density * (2.f * moments[2] - moments[0])};
+}
+
+Multipole combineMultipoles(const std::vector<Multipole>& multipoles) {
+    Multipole res;
+    for (const Multipole& multipole : multipoles) {
+        res.mass += multipole.mass;
+        res.center += multipole.mass * multipole.center;
+    }
+    if (res.mass <= 0) {
+        return res;
+    }
+    res.center /= res.mass;
+    // Parallel axis theorem, on the moments of each mass about its own center
+    for (const Multipole& multipole : multipoles) {
+        const Vector2f d{multipole.center - res.center};
+        res.xx += multipole.xx + multipole.mass * (2.f * d.x * d.x - d.y * d.y);
+        res.xy += multipole.xy + multipole.mass * 3.f * d.x * d.y;
+        res.yy += multipole.yy + multipole.mass * (2.f * d.y * d.y - d.x * d.x);
+    }
+    return res;
+}
+
+Vector2f multipoleField(const Multipole& multipole, const Vector2f& position) {
+    const Vector2f r{position - multipole.center};
+    const float dist{norm(r)};
+    return -multipole.mass * r / (dist * dist * dist) + quadrupoleField(multipole, position);
+}
+
+Vector2f quadrupoleField(const Multipole& multipole, const Vector2f& position) {
+    // Gradient of the potential r^T Q r / (2 |r|^5)
+    const Vector2f r{position - multipole.center};
+    const float r2{norm2(r)};
+    const float invR2{1.f / r2};
+    const float invR5{invR2 * invR2 / std::sqrt(r2)};
+    const Vector2f qr{multipole.xx * r.x + multipole.xy * r.y, multipole.xy * r.x + multipole.yy * r.y};
+    return invR5 * (qr - 2.5f * dot(r, qr) * invR2 * r);
+}
+
+Vector2f extendedField(const Multipole& multipole, const std::vector<Multipole>& components,
+        float rotation, float nearField, float mass, float softening2, const Vector2f& r) {
+    const Vector2f local{rotate(r, -rotation)};
+    if (norm2(local) >= nearField * nearField) {
+        return rotate(quadrupoleField(multipole, local), rotation);
+    }
+    Vector2f near{0, 0};
+    for (const Multipole& component : components) {
+        near += multipoleField(component, local);
+    }
+    // Remove the point mass as the solvers evaluate it
+    const float r2{norm2(r) + softening2};
+    return rotate(near, rotation) + mass * r / (r2 * std::sqrt(r2));
+}
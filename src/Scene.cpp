@@ -2,17 +2,201 @@
 
 EntityId Scene::createEntity() {
     EntityId id;
-    if (not _freeIds.empty()) {
-        id = _freeIds.extract(0).value();
+    if (_freeHead == nullEntityIndex) {
+        id = static_cast<EntityId>(_entities.size());
+        // If this assert triggers, there are too many entities alive at once
+        // for the number of index bits.
+        assert(id < nullEntityIndex);
+        _entities.push_back(id);
     } else {
-        id = _maxEntityId++;
+        const EntityId index{_freeHead};
+        const EntityId slot{_entities[index]};
+        _freeHead = entityIndex(slot);
+        id = makeEntityId(index, entityVersion(slot));
+        _entities[index] = id;
     }
     return id;
 }
 
 void Scene::removeEntity(EntityId id) {
-    for (auto& [type, array] : _arrays) {
-        array->erase(id);
+    assert(isValid(id));
+    for (auto& array : _arrays) {
+        if (array and array->contains(id)) {
+            removeFromGroups(*array, id);
+            array->erase(id);
+        }
+    }
+    freeEntity(id);
+}
+
+bool Scene::isValid(EntityId id) const {
+    const EntityId index{entityIndex(id)};
+    return index < _entities.size() and _entities[index] == id;
+}
+
+Scene::EntityRange Scene::allEntities() const {
+    return EntityRange(_entities);
+}
+
+Scene::CommandBuffer& Scene::commands() {
+    return _commands;
+}
+
+void Scene::freeEntity(EntityId id) {
+    const EntityId index{entityIndex(id)};
+    _entities[index] = makeEntityId(_freeHead, entityVersion(id) + 1);
+    _freeHead = index;
+}
+
+void Scene::registerGroup(std::vector<std::size_t> typeIds) {
+    std::sort(typeIds.begin(), typeIds.end());
+    auto group = std::make_unique<GroupData>();
+    group->typeIds = typeIds;
+    for (std::size_t typeId : typeIds) {
+        // If this assert triggers, the component is not registered yet
+        assert(typeId < _arrays.size() and _arrays[typeId] != nullptr);
+        group->arrays.push_back(_arrays[typeId].get());
+    }
+    // A group sharing more than one array with another one would need to
+    // rotate the segments of that group in both arrays at once.
+    for (const auto& other : _groups) {
+        std::vector<std::size_t> shared;
+        std::set_intersection(typeIds.begin(), typeIds.end(),
+            other->typeIds.begin(), other->typeIds.end(), std::back_inserter(shared));
+        assert(shared.size() <= 1);
+    }
+    for (ArrayConcept* array : group->arrays) {
+        array->owners.push_back(group.get());
+    }
+    _groups.push_back(std::move(group));
+
+    // Gather the existing entities. Copy the IDs first since joining the
+    // group reorders the arrays.
+    GroupData& data{*_groups.back()};
+    const ArrayConcept& first{*data.arrays.front()};
+    const std::vector<EntityId> candidates(first.entities(), first.entities() + first.size());
+    for (EntityId id : candidates) {
+        if (std::all_of(data.arrays.begin(), data.arrays.end(),
+                [id] (const ArrayConcept* array) { return array->contains(id); })) {
+            addToGroup(data, id);
+        }
+    }
+}
+
+void Scene::addToGroups(ArrayConcept& array, EntityId id) {
+    for (GroupData* group : array.owners) {
+        if (std::all_of(group->arrays.begin(), group->arrays.end(),
+                [id] (const ArrayConcept* other) { return other->contains(id); })) {
+            addToGroup(*group, id);
+        }
+    }
+}
+
+void Scene::removeFromGroups(ArrayConcept& array, EntityId id) {
+    for (GroupData* group : array.owners) {
+        const std::size_t start{array.segmentStart(*group)};
+        const std::size_t index{array.index(id)};
+        if (index >= start and index < start + group->size) {
+            removeFromGroup(*group, id);
+        }
+    }
+}
+
+void Scene::addToGroup(GroupData& group, EntityId id) {
+    for (ArrayConcept* array : group.arrays) {
+        // If this assert triggers, the entity is in two groups owning the
+        // same array.
+        assert(array->index(id) >= array->groupedSize());
+        // Move the entity right after the grouped entities
+        array->swapEntries(array->index(id), array->groupedSize());
+        // Move the entity at the end of the segment of the group, by moving
+        // the first entity of each of the following segments at its end.
+        // This rotates the entities of these groups, so they have to be
+        // rotated in their other arrays as well.
+        for (auto it = array->owners.rbegin(); *it != &group; ++it) {
+            GroupData& other{**it};
+            const std::size_t start{array->segmentStart(other)};
+            array->swapEntries(start, start + other.size);
+            for (ArrayConcept* otherArray : other.arrays) {
+                if (otherArray != array) {
+                    otherArray->rotateLeft(otherArray->segmentStart(other), other.size);
+                }
+            }
+        }
+    }
+    ++group.size;
+}
+
+void Scene::removeFromGroup(GroupData& group, EntityId id) {
+    for (ArrayConcept* array : group.arrays) {
+        // Move the entity at the end of the segment of the group
+        array->swapEntries(array->index(id), array->segmentStart(group) + group.size - 1);
+        // Move the entity after the grouped entities, by moving the last
+        // entity of each of the following segments at its front.
+        auto it = std::find(array->owners.begin(), array->owners.end(), &group);
+        for (++it; it != array->owners.end(); ++it) {
+            GroupData& other{**it};
+            const std::size_t start{array->segmentStart(other)};
+            if (other.size > 0) {
+                array->swapEntries(start - 1, start + other.size - 1);
+                for (ArrayConcept* otherArray : other.arrays) {
+                    if (otherArray != array) {
+                        otherArray->rotateRight(otherArray->segmentStart(other), other.size);
+                    }
+                }
+            }
+        }
+    }
+    --group.size;
+}
+
+Scene::CommandBuffer::CommandBuffer(Scene& scene):
+    _scene{scene} {
+}
+
+EntityId Scene::CommandBuffer::createEntity() {
+    return _scene.createEntity();
+}
+
+void Scene::CommandBuffer::removeEntity(EntityId id) {
+    _removals.push_back(id);
+}
+
+void Scene::CommandBuffer::apply() {
+    // Erasures, grouped by component array
+    std::sort(_erasures.begin(), _erasures.end());
+    for (auto [typeId, id] : _erasures) {
+        ArrayConcept& array{*_scene._arrays[typeId]};
+        if (_scene.isValid(id) and array.contains(id)) {
+            _scene.removeFromGroups(array, id);
+            array.erase(id);
+        }
+    }
+    _erasures.clear();
+
+    // Removals, one pass per component array
+    std::sort(_removals.begin(), _removals.end());
+    _removals.erase(std::unique(_removals.begin(), _removals.end()), _removals.end());
+    _removals.erase(std::remove_if(_removals.begin(), _removals.end(),
+        [this] (EntityId id) { return not _scene.isValid(id); }), _removals.end());
+    for (auto& array : _scene._arrays) {
+        if (array) {
+            for (EntityId id : _removals) {
+                if (array->contains(id)) {
+                    _scene.removeFromGroups(*array, id);
+                    array->erase(id);
+                }
+            }
+        }
+    }
+    for (EntityId id : _removals) {
+        _scene.freeEntity(id);
+    }
+    _removals.clear();
+
+    for (auto& pending : _assignments) {
+        if (pending) {
+            pending->apply(_scene);
+        }
     }
-    _freeIds.insert(id);
 }
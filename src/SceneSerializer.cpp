@@ -46,6 +46,7 @@ void SceneSerializer::load(const std::filesystem::path& path) {
         {"animations", &SceneSerializer::loadAnimations},
         {"player", &SceneSerializer::loadPlayer},
         {"lightSource", &SceneSerializer::loadLightSource},
+        {"gravitySource", &SceneSerializer::loadGravitySource},
         {"mapElement", &SceneSerializer::loadMapElement},
         {"soundEffects", &SceneSerializer::loadSoundEffects}
     };
@@ -85,6 +86,7 @@ void SceneSerializer::save(const std::filesystem::path& path) const {
         saveComponent<Animations>(entityValue, id, "animations");
         saveComponent<Player>(entityValue, id, "player");
         saveComponent<LightSource>(entityValue, id, "lightSource");
+        saveComponent<GravitySource>(entityValue, id, "gravitySource");
         saveComponent<MapElement>(entityValue, id, "mapElement");
         saveComponent<SoundEffects>(entityValue, id, "soundEffects");
 
@@ -123,7 +125,7 @@ json SceneSerializer::computeClassPatch(const json& classValue, const json& enti
 }
 
 void SceneSerializer::loadBody(const json& value, EntityId id) {
-    value.get_to(_scene.assignComponent<Body>(id));
+    _scene.assignComponent<Body>(id, value.get<Body>());
 }
 
 void SceneSerializer::loadCircleBody(const json& value, EntityId id) {
@@ -195,6 +197,10 @@ void SceneSerializer::loadLightSource(const json& value, EntityId id) {
     value.get_to(_scene.assignComponent<LightSource>(id));
 }
 
+void SceneSerializer::loadGravitySource(const json& value, EntityId id) {
+    value.get_to(_scene.assignComponent<GravitySource>(id));
+}
+
 void SceneSerializer::loadMapElement(const json& value, EntityId id) {
     MapElement& mapElement{_scene.assignComponent<MapElement>(id)};
     value.get_to(mapElement);
@@ -19,3 +19,69 @@ void Settings::saveSettings(const Settings& settings) {
     std::ofstream file{Paths::getSettingsPath()};
     file << std::setw(4) << nlohmann::json(settings) << std::endl;
 }
+
+void to_json(nlohmann::json& j, const PhysicsSettings& settings) {
+    j = {
+        {"stepsPerSecond", settings.stepsPerSecond},
+        {"renderInterpolation", settings.renderInterpolation},
+        {"integrator", settings.integrator},
+        {"gravitySolver", settings.gravitySolver},
+        {"barnesHutTheta", settings.barnesHutTheta},
+        {"gravitySourceMassThreshold", settings.gravitySourceMassThreshold},
+        {"physicsThreads", settings.physicsThreads},
+        {"blockTimesteps", settings.blockTimesteps},
+        {"maxBlockLevel", settings.maxBlockLevel},
+        {"blockTimestepAccuracy", settings.blockTimestepAccuracy},
+        {"closeEncounterSteps", settings.closeEncounterSteps},
+        {"nearFieldRadii", settings.nearFieldRadii},
+        {"railsTimeScale", settings.railsTimeScale},
+        {"keyframeInterval", settings.keyframeInterval},
+        {"rewindMemory", settings.rewindMemory},
+        {"predictionHorizon", settings.predictionHorizon},
+        {"predictionTimeStep", settings.predictionTimeStep}
+    };
+}
+
+void from_json(const nlohmann::json& j, PhysicsSettings& settings) {
+    const PhysicsSettings defaults;
+    settings.stepsPerSecond = j.value("stepsPerSecond", defaults.stepsPerSecond);
+    settings.renderInterpolation = j.value("renderInterpolation", defaults.renderInterpolation);
+    settings.integrator = j.value("integrator", defaults.integrator);
+    settings.gravitySolver = j.value("gravitySolver", defaults.gravitySolver);
+    settings.barnesHutTheta = j.value("barnesHutTheta", defaults.barnesHutTheta);
+    settings.gravitySourceMassThreshold = j.value("gravitySourceMassThreshold",
+        defaults.gravitySourceMassThreshold);
+    settings.physicsThreads = j.value("physicsThreads", defaults.physicsThreads);
+    settings.blockTimesteps = j.value("blockTimesteps", defaults.blockTimesteps);
+    settings.maxBlockLevel = j.value("maxBlockLevel", defaults.maxBlockLevel);
+    settings.blockTimestepAccuracy = j.value("blockTimestepAccuracy", defaults.blockTimestepAccuracy);
+    settings.closeEncounterSteps = j.value("closeEncounterSteps", defaults.closeEncounterSteps);
+    settings.nearFieldRadii = j.value("nearFieldRadii", defaults.nearFieldRadii);
+    settings.railsTimeScale = j.value("railsTimeScale", defaults.railsTimeScale);
+    settings.keyframeInterval = j.value("keyframeInterval", defaults.keyframeInterval);
+    settings.rewindMemory = j.value("rewindMemory", defaults.rewindMemory);
+    settings.predictionHorizon = j.value("predictionHorizon", defaults.predictionHorizon);
+    settings.predictionTimeStep = j.value("predictionTimeStep", defaults.predictionTimeStep);
+}
+
+void to_json(nlohmann::json& j, const Settings& settings) {
+    j = {
+        {"soundSettings", settings.soundSettings},
+        {"physicsSettings", settings.physicsSettings},
+        {"videoMode", settings.videoMode},
+        {"gameKeyboardMapping", settings.gameKeyboardMapping},
+        {"gameControllerMapping", settings.gameControllerMapping},
+        {"mapKeyboardMapping", settings.mapKeyboardMapping},
+        {"mapControllerMapping", settings.mapControllerMapping}
+    };
+}
+
+void from_json(const nlohmann::json& j, Settings& settings) {
+    j.at("soundSettings").get_to(settings.soundSettings);
+    settings.physicsSettings = j.value("physicsSettings", PhysicsSettings{});
+    j.at("videoMode").get_to(settings.videoMode);
+    j.at("gameKeyboardMapping").get_to(settings.gameKeyboardMapping);
+    j.at("gameControllerMapping").get_to(settings.gameControllerMapping);
+    j.at("mapKeyboardMapping").get_to(settings.mapKeyboardMapping);
+    j.at("mapControllerMapping").get_to(settings.mapControllerMapping);
+}
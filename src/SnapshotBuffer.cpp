@@ -0,0 +1,185 @@
+#include <algorithm>
+#include <SnapshotBuffer.hpp>
+#include <Scene.hpp>
+#include <components/Body.hpp>
+
+void SnapshotBuffer::setMemoryBudget(std::size_t bytes) {
+    _budget = bytes;
+}
+
+void SnapshotBuffer::record(long long int step, Scene& scene) {
+    while (_size > 0 and at(_size - 1).step >= step) {
+        --_size;
+    }
+    while (not _changes.empty() and _changes.back().step >= step) {
+        _changes.pop_back();
+    }
+    const ComponentStorage<Body>& bodies{scene.components<Body>()};
+    const std::size_t capacity{_budget / keyframeSize(bodies.size())};
+    if (capacity == 0) {
+        // Frees the keyframes and the changes
+        setCapacity(0);
+        return;
+    }
+    if (capacity != _keyframes.size()) {
+        setCapacity(capacity);
+    }
+
+    // Overwrite the oldest keyframe when full
+    if (_size == _keyframes.size()) {
+        _first = (_first + 1) % _keyframes.size();
+        --_size;
+    }
+    ++_size;
+    Keyframe& keyframe{at(_size - 1)};
+    _keyframeMemory -= arraysMemory(keyframe);
+    const EntityId* entities{scene.componentEntities<Body>()};
+    keyframe.step = step;
+    keyframe.entities.assign(entities, entities + bodies.size());
+    keyframe.positions = bodies.positions;
+    keyframe.velocities = bodies.velocities;
+    keyframe.rotations = bodies.rotations;
+    keyframe.angularVelocities = bodies.angularVelocities;
+    _keyframeMemory += arraysMemory(keyframe);
+    dropOldChanges();
+    fitBudget();
+}
+
+bool SnapshotBuffer::restore(long long int step, Scene& scene, long long int& restoredStep) const {
+    std::size_t i{_size};
+    while (i > 0 and at(i - 1).step > step) {
+        --i;
+    }
+    if (i == 0) {
+        return false;
+    }
+    const Keyframe& keyframe{at(i - 1)};
+    restoredStep = keyframe.step;
+
+    ComponentStorage<Body>& bodies{scene.components<Body>()};
+    const EntityId* entities{scene.componentEntities<Body>()};
+    if (keyframe.entities.size() == bodies.size()
+            and std::equal(keyframe.entities.begin(), keyframe.entities.end(), entities)) {
+        // Same bodies in the same order, copy the arrays as a whole
+        bodies.positions = keyframe.positions;
+        bodies.velocities = keyframe.velocities;
+        bodies.rotations = keyframe.rotations;
+        bodies.angularVelocities = keyframe.angularVelocities;
+    } else {
+        for (std::size_t j{0}; j < keyframe.entities.size(); ++j) {
+            const EntityId id{keyframe.entities[j]};
+            if (scene.isValid(id) and scene.hasComponent<Body>(id)) {
+                const std::size_t index{scene.componentIndex<Body>(id)};
+                bodies.positions[index] = keyframe.positions[j];
+                bodies.velocities[index] = keyframe.velocities[j];
+                bodies.rotations[index] = keyframe.rotations[j];
+                bodies.angularVelocities[index] = keyframe.angularVelocities[j];
+            }
+        }
+    }
+    scene.markAllChanged<Body>();
+    return true;
+}
+
+bool SnapshotBuffer::contains(long long int step) const {
+    std::size_t i{_size};
+    while (i > 0 and at(i - 1).step > step) {
+        --i;
+    }
+    return i > 0 and at(i - 1).step == step;
+}
+
+void SnapshotBuffer::clear() {
+    _size = 0;
+    _changes.clear();
+}
+
+void SnapshotBuffer::recordChanges(long long int step, Scene& scene, std::uint64_t since) {
+    while (not _changes.empty() and _changes.back().step >= step) {
+        _changes.pop_back();
+    }
+    // Changes before the first keyframe are never replayed
+    if (_size == 0) {
+        return;
+    }
+    for (auto [id, body] : scene.changed<Body>(since)) {
+        _changes.push_back({step, id, body.position, body.velocity,
+            body.rotation, body.angularVelocity});
+    }
+    fitBudget();
+}
+
+void SnapshotBuffer::replayChanges(long long int step, Scene& scene) const {
+    auto it{std::lower_bound(_changes.begin(), _changes.end(), step,
+        [](const Change& change, long long int value) {
+            return change.step < value;
+        })};
+    for (; it != _changes.end() and it->step == step; ++it) {
+        if (scene.isValid(it->entity) and scene.hasComponent<Body>(it->entity)) {
+            BodyRef body{scene.patchComponent<Body>(it->entity)};
+            body.position = it->position;
+            body.velocity = it->velocity;
+            body.rotation = it->rotation;
+            body.angularVelocity = it->angularVelocity;
+        }
+    }
+}
+
+std::size_t SnapshotBuffer::size() const {
+    return _size;
+}
+
+std::size_t SnapshotBuffer::memoryUsage() const {
+    return _keyframes.capacity() * sizeof(Keyframe) + _keyframeMemory + _changes.size() * sizeof(Change);
+}
+
+std::size_t SnapshotBuffer::keyframeSize(std::size_t bodies) {
+    return sizeof(Keyframe) + bodies * (sizeof(EntityId) + 2 * sizeof(Vector2f) + 2 * sizeof(float));
+}
+
+SnapshotBuffer::Keyframe& SnapshotBuffer::at(std::size_t i) {
+    return _keyframes[(_first + i) % _keyframes.size()];
+}
+
+const SnapshotBuffer::Keyframe& SnapshotBuffer::at(std::size_t i) const {
+    return _keyframes[(_first + i) % _keyframes.size()];
+}
+
+void SnapshotBuffer::setCapacity(std::size_t capacity) {
+    // Keep the newest keyframes, from index 0 of the new ring
+    std::vector<Keyframe> keyframes(capacity);
+    const std::size_t kept{std::min(_size, capacity)};
+    for (std::size_t i{0}; i < kept; ++i) {
+        keyframes[i] = std::move(at(_size - kept + i));
+    }
+    _keyframes = std::move(keyframes);
+    _first = 0;
+    _size = kept;
+    _keyframeMemory = 0;
+    for (const Keyframe& keyframe : _keyframes) {
+        _keyframeMemory += arraysMemory(keyframe);
+    }
+    dropOldChanges();
+}
+
+void SnapshotBuffer::dropOldChanges() {
+    while (not _changes.empty() and (_size == 0 or _changes.front().step < at(0).step)) {
+        _changes.pop_front();
+    }
+}
+
+void SnapshotBuffer::fitBudget() {
+    while (_size > 0 and memoryUsage() > _budget) {
+        _keyframeMemory -= arraysMemory(at(0));
+        at(0) = Keyframe{};
+        _first = (_first + 1) % _keyframes.size();
+        --_size;
+        dropOldChanges();
+    }
+}
+
+std::size_t SnapshotBuffer::arraysMemory(const Keyframe& keyframe) {
+    return keyframe.entities.capacity() * sizeof(EntityId)
+        + (keyframe.positions.capacity() + keyframe.velocities.capacity()) * sizeof(Vector2f)
+        + (keyframe.rotations.capacity() + keyframe.angularVelocities.capacity()) * sizeof(float);
+}
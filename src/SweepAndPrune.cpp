@@ -0,0 +1,62 @@
+#include <algorithm>
+#include <SweepAndPrune.hpp>
+
+void SweepAndPrune::update(const std::vector<Box>& boxes) {
+    const std::uint32_t n{static_cast<std::uint32_t>(boxes.size())};
+    if (_bounds.size() != 2 * boxes.size()) {
+        // The boxes changed, sort again from scratch
+        _bounds.clear();
+        for (std::uint32_t i{0}; i < n; ++i) {
+            _bounds.push_back({boxes[i].min.x, i << 1});
+            _bounds.push_back({boxes[i].max.x, (i << 1) | 1});
+        }
+        std::sort(_bounds.begin(), _bounds.end(), less);
+    } else {
+        for (Bound& bound : _bounds) {
+            const Box& box{boxes[bound.data >> 1]};
+            bound.value = (bound.data & 1) ? box.max.x : box.min.x;
+        }
+        // Insertion sort, each bound only moves past the few bounds it crossed
+        for (std::size_t i{1}; i < _bounds.size(); ++i) {
+            const Bound bound{_bounds[i]};
+            std::size_t j{i};
+            for (; j > 0 and less(bound, _bounds[j - 1]); --j) {
+                _bounds[j] = _bounds[j - 1];
+            }
+            _bounds[j] = bound;
+        }
+    }
+
+    _pairs.clear();
+    _active.clear();
+    _activeSlots.resize(n);
+    for (const Bound& bound : _bounds) {
+        const std::uint32_t i{bound.data >> 1};
+        if (bound.data & 1) {
+            // Remove the box from the active ones by moving the last one in
+            // its place
+            const std::uint32_t slot{_activeSlots[i]};
+            _active[slot] = _active.back();
+            _activeSlots[_active[slot]] = slot;
+            _active.pop_back();
+            continue;
+        }
+        const Box& box{boxes[i]};
+        for (std::uint32_t j : _active) {
+            if (box.min.y <= boxes[j].max.y and boxes[j].min.y <= box.max.y) {
+                _pairs.emplace_back(std::min(i, j), std::max(i, j));
+            }
+        }
+        _activeSlots[i] = static_cast<std::uint32_t>(_active.size());
+        _active.push_back(i);
+    }
+    std::sort(_pairs.begin(), _pairs.end());
+}
+
+const std::vector<std::pair<std::uint32_t, std::uint32_t>>& SweepAndPrune::getPairs() const {
+    return _pairs;
+}
+
+bool SweepAndPrune::less(const Bound& a, const Bound& b) {
+    return a.value < b.value or (not (b.value < a.value) and (a.data & 1) < (b.data & 1));
+}
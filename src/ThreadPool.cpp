@@ -0,0 +1,82 @@
+#include <algorithm>
+#include <ThreadPool.hpp>
+
+ThreadPool::ThreadPool(std::size_t threads) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (std::size_t i{1}; i < threads; ++i) {
+        _workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock{_mutex};
+        _stopping = true;
+    }
+    _workAvailable.notify_all();
+    for (std::thread& worker : _workers) {
+        worker.join();
+    }
+}
+
+std::size_t ThreadPool::size() const {
+    return _workers.size() + 1;
+}
+
+void ThreadPool::parallelFor(std::size_t count, std::size_t grain,
+        const std::function<void(std::size_t, std::size_t)>& function) {
+    if (_workers.empty() or count <= grain) {
+        if (count > 0) {
+            function(0, count);
+        }
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock{_mutex};
+        _function = &function;
+        _count = count;
+        // A few chunks per thread, so that a thread that is late to wake up
+        // does not delay the whole loop
+        _chunkSize = std::max(grain, (count + 4 * size() - 1) / (4 * size()));
+        _nextChunk = 0;
+        _busyWorkers = _workers.size();
+        ++_generation;
+    }
+    _workAvailable.notify_all();
+    runChunks();
+
+    std::unique_lock<std::mutex> lock{_mutex};
+    _workDone.wait(lock, [this] { return _busyWorkers == 0; });
+    _function = nullptr;
+}
+
+void ThreadPool::workerLoop() {
+    std::uint64_t generation{0};
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock{_mutex};
+            _workAvailable.wait(lock, [&] { return _stopping or _generation != generation; });
+            if (_stopping) {
+                return;
+            }
+            generation = _generation;
+        }
+        runChunks();
+        std::lock_guard<std::mutex> lock{_mutex};
+        if (--_busyWorkers == 0) {
+            _workDone.notify_one();
+        }
+    }
+}
+
+void ThreadPool::runChunks() {
+    while (true) {
+        const std::size_t begin{_nextChunk.fetch_add(1) * _chunkSize};
+        if (begin >= _count) {
+            return;
+        }
+        (*_function)(begin, std::min(_count, begin + _chunkSize));
+    }
+}
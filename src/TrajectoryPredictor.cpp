@@ -0,0 +1,271 @@
+#include <algorithm>
+#include <cmath>
+#include <TrajectoryPredictor.hpp>
+#include <systems/PhysicsSystem.hpp>
+#include <Scene.hpp>
+#include <Settings.hpp>
+#include <components/Body.hpp>
+#include <components/components.hpp>
+
+TrajectoryPredictor::TrajectoryPredictor(const PhysicsSettings& settings):
+    _settings{settings},
+    _worker{&TrajectoryPredictor::workerLoop, this} {
+}
+
+TrajectoryPredictor::~TrajectoryPredictor() {
+    {
+        std::lock_guard<std::mutex> lock{_mutex};
+        _stopping = true;
+    }
+    _jobAvailable.notify_one();
+    _worker.join();
+}
+
+void TrajectoryPredictor::invalidate(EntityId id) {
+    if (std::find(_invalidated.begin(), _invalidated.end(), id) == _invalidated.end()) {
+        _invalidated.push_back(id);
+    }
+}
+
+void TrajectoryPredictor::update(Scene& scene, const PhysicsSystem& physics) {
+    const double time{static_cast<double>(physics.getElapsedTime().asMicroseconds()) * 1e-6};
+    const double horizon{static_cast<double>(_settings.predictionHorizon)};
+    // Predict everything again when the table of the sources does not cover
+    // the time ahead anymore
+    if (time < _tableTime or time > _tableTime + horizon / 2.) {
+        _fullInvalidation = true;
+    }
+    if (not _fullInvalidation and _invalidated.empty()) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock{_mutex};
+    // The new job replaces the one the worker did not start yet, so it has to
+    // do all of its work too
+    if (_job.has_value()) {
+        if (_job->full) {
+            _fullInvalidation = true;
+        }
+        for (EntityId id : _job->entities) {
+            invalidate(id);
+        }
+    }
+    Job job;
+    job.full = _fullInvalidation;
+    job.time = time;
+    job.horizon = horizon;
+    job.timeStep = static_cast<double>(_settings.predictionTimeStep);
+    job.gravitationalConstant = physics.getGravitationalConstant();
+    ComponentStorage<Body>& bodies{scene.components<Body>()};
+    const EntityId* entities{scene.componentEntities<Body>()};
+    for (std::size_t i{0}; i < bodies.size(); ++i) {
+        const EntityId id{entities[i]};
+        if (physics.isGravitySource(id, bodies.masses[i])) {
+            if (job.full) {
+                job.sourceEntities.push_back(id);
+                job.sourcePositions.push_back(bodies.positions[i]);
+                job.sourceVelocities.push_back(bodies.velocities[i]);
+                job.sourceMasses.push_back(bodies.masses[i]);
+                const float softening{scene.hasComponent<GravitySource>(id)
+                    ? scene.getComponent<GravitySource>(id).softening : 0.f};
+                job.sourceSoftenings.push_back(softening * softening);
+                job.sourceRadii.push_back(scene.hasComponent<CircleBody>(id)
+                    ? scene.getComponent<CircleBody>(id).radius : 0.f);
+                // Same sources as PhysicsSystem::gatherSources
+                if (_settings.nearFieldRadii > 0 and scene.hasComponent<PolygonBody>(id)) {
+                    const PolygonBody& polygon{scene.getComponent<PolygonBody>(id)};
+                    job.extendedSources.push_back({job.sourceEntities.size() - 1,
+                        polygon.multipole, polygon.componentMultipoles,
+                        _settings.nearFieldRadii * polygon.radius,
+                        bodies.rotations[i], bodies.angularVelocities[i]});
+                }
+            }
+        } else if (scene.hasComponent<MapElement>(id) and (job.full
+                or std::find(_invalidated.begin(), _invalidated.end(), id) != _invalidated.end())) {
+            job.entities.push_back(id);
+            job.positions.push_back(bodies.positions[i]);
+            job.velocities.push_back(bodies.velocities[i]);
+        }
+    }
+    if (job.full) {
+        _tableTime = time;
+    }
+    _fullJobPending = job.full;
+    _job = std::move(job);
+    _invalidated.clear();
+    _fullInvalidation = false;
+    _jobAvailable.notify_one();
+}
+
+std::shared_ptr<const TrajectoryPredictor::Prediction> TrajectoryPredictor::getPrediction() const {
+    std::lock_guard<std::mutex> lock{_mutex};
+    return _prediction;
+}
+
+void TrajectoryPredictor::workerLoop() {
+    while (true) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock{_mutex};
+            _jobAvailable.wait(lock, [this] { return _stopping or _job.has_value(); });
+            if (_stopping) {
+                return;
+            }
+            job = std::move(*_job);
+            _job.reset();
+            _fullJobPending = false;
+        }
+        if (job.full) {
+            if (not predictSources(job)) {
+                continue;
+            }
+            _trajectoryEntities.clear();
+            _trajectories.clear();
+        }
+        for (std::size_t k{0}; k < job.entities.size(); ++k) {
+            const auto it = std::find(_trajectoryEntities.begin(), _trajectoryEntities.end(), job.entities[k]);
+            const std::size_t slot{static_cast<std::size_t>(it - _trajectoryEntities.begin())};
+            if (it == _trajectoryEntities.end()) {
+                _trajectoryEntities.push_back(job.entities[k]);
+                _trajectories.emplace_back();
+            }
+            predictBody(job, job.positions[k], job.velocities[k], _trajectories[slot]);
+        }
+        publish();
+    }
+}
+
+bool TrajectoryPredictor::predictSources(const Job& job) {
+    const std::size_t n{job.sourceEntities.size()};
+    _workerTableTime = job.time;
+    _workerTimeStep = job.timeStep;
+    _workerSteps = static_cast<std::size_t>(std::ceil(job.horizon / job.timeStep));
+    _workerSources = job.sourceEntities;
+    _workerMasses = job.sourceMasses;
+    _workerSoftenings = job.sourceSoftenings;
+    _workerRadii = job.sourceRadii;
+    _workerExtended = job.extendedSources;
+    _table.resize((_workerSteps + 1) * n);
+
+    // Leapfrog in kick-drift-kick form, which only needs the forces at the
+    // steps, and keeps the orbits closed over the long run
+    const float h{static_cast<float>(job.timeStep)};
+    std::vector<Vector2f> positions{job.sourcePositions};
+    std::vector<Vector2f> velocities{job.sourceVelocities};
+    std::vector<Vector2f> accelerations(n);
+    const auto accelerate = [&](double time) {
+        for (std::size_t i{0}; i < n; ++i) {
+            accelerations[i] = computeField(positions, positions[i], i, time) * job.gravitationalConstant;
+        }
+    };
+    accelerate(0);
+    std::copy(positions.begin(), positions.end(), _table.begin());
+    for (std::size_t s{1}; s <= _workerSteps; ++s) {
+        if (_fullJobPending or _stopping) {
+            _workerSteps = 0;
+            return false;
+        }
+        for (std::size_t i{0}; i < n; ++i) {
+            velocities[i] += accelerations[i] * h / 2.f;
+            positions[i] += velocities[i] * h;
+        }
+        accelerate(static_cast<double>(s) * job.timeStep);
+        for (std::size_t i{0}; i < n; ++i) {
+            velocities[i] += accelerations[i] * h / 2.f;
+        }
+        std::copy(positions.begin(), positions.end(), _table.begin() + static_cast<std::ptrdiff_t>(s * n));
+    }
+    return true;
+}
+
+void TrajectoryPredictor::predictBody(const Job& job, const Vector2f& position,
+        const Vector2f& velocity, std::vector<Vector2f>& trajectory) const {
+    const double start{job.time - _workerTableTime};
+    const double end{static_cast<double>(_workerSteps) * _workerTimeStep};
+    const std::size_t steps{start < end ? static_cast<std::size_t>((end - start) / _workerTimeStep) : 0};
+    const std::size_t stride{steps / _maxPoints + 1};
+    const float h{static_cast<float>(_workerTimeStep)};
+    std::vector<Vector2f> sources(_workerSources.size());
+    Vector2f x{position};
+    Vector2f v{velocity};
+    const auto acceleration = [&](double time) {
+        interpolateSources(time, sources);
+        return computeField(sources, x, sources.size(), time) * job.gravitationalConstant;
+    };
+
+    trajectory.clear();
+    trajectory.push_back(x);
+    Vector2f a{acceleration(start)};
+    for (std::size_t s{1}; s <= steps; ++s) {
+        v += a * h / 2.f;
+        x += v * h;
+        a = acceleration(start + static_cast<double>(s) * _workerTimeStep);
+        v += a * h / 2.f;
+        bool hit{false};
+        for (std::size_t i{0}; i < sources.size(); ++i) {
+            hit = hit or norm(x - sources[i]) < _workerRadii[i];
+        }
+        if (hit or s % stride == 0 or s == steps) {
+            trajectory.push_back(x);
+        }
+        if (hit) {
+            break;
+        }
+    }
+}
+
+void TrajectoryPredictor::interpolateSources(double time, std::vector<Vector2f>& positions) const {
+    const std::size_t n{positions.size()};
+    if (_workerSteps == 0) {
+        std::copy(_table.begin(), _table.begin() + static_cast<std::ptrdiff_t>(n), positions.begin());
+        return;
+    }
+    const double u{std::max(0., time / _workerTimeStep)};
+    const std::size_t s{std::min(static_cast<std::size_t>(u), _workerSteps - 1)};
+    const float f{static_cast<float>(u - static_cast<double>(s))};
+    for (std::size_t i{0}; i < n; ++i) {
+        const Vector2f& a{_table[s * n + i]};
+        const Vector2f& b{_table[(s + 1) * n + i]};
+        positions[i] = a + f * (b - a);
+    }
+}
+
+Vector2f TrajectoryPredictor::computeField(const std::vector<Vector2f>& sources,
+        const Vector2f& position, std::size_t self, double time) const {
+    Vector2f field{gravityField(_gravityKernel, sources, _workerMasses, _workerSoftenings, position, self)};
+    for (const ExtendedSource& extended : _workerExtended) {
+        const std::size_t k{extended.source};
+        if (k != self) {
+            const float rotation{extended.rotation + extended.angularVelocity * static_cast<float>(time)};
+            field += extendedField(extended.multipole, extended.componentMultipoles, rotation,
+                extended.nearField, _workerMasses[k], _workerSoftenings[k], position - sources[k]);
+        }
+    }
+    return field;
+}
+
+void TrajectoryPredictor::publish() {
+    Prediction prediction;
+    prediction.generation = ++_generation;
+    const std::size_t n{_workerSources.size()};
+    const std::size_t stride{_workerSteps / _maxPoints + 1};
+    for (std::size_t i{0}; i < n; ++i) {
+        prediction.entities.push_back(_workerSources[i]);
+        prediction.offsets.push_back(prediction.points.size());
+        for (std::size_t s{0}; s <= _workerSteps; ++s) {
+            if (s % stride == 0 or s == _workerSteps) {
+                prediction.points.push_back(_table[s * n + i]);
+            }
+        }
+    }
+    for (std::size_t k{0}; k < _trajectoryEntities.size(); ++k) {
+        prediction.entities.push_back(_trajectoryEntities[k]);
+        prediction.offsets.push_back(prediction.points.size());
+        prediction.points.insert(prediction.points.end(), _trajectories[k].begin(), _trajectories[k].end());
+    }
+    prediction.offsets.push_back(prediction.points.size());
+
+    std::shared_ptr<const Prediction> published{std::make_shared<const Prediction>(std::move(prediction))};
+    std::lock_guard<std::mutex> lock{_mutex};
+    _prediction = std::move(published);
+}
@@ -10,15 +10,119 @@ Vector2f Body::worldToLocal(const Vector2f& point) const {
     return rotate(point - position, -rotation);
 }
 
-std::vector<Vector2f> Body::shadowTerminator(const Vector2f& lightSource, const Scene& scene, EntityId id) const {
-    if (scene.hasComponent<CircleBody>(id)) {
-        return scene.getComponent<CircleBody>(id).shadowTerminator(lightSource, *this);
-    } else {
-        return scene.getComponent<PolygonBody>(id).shadowTerminator(lightSource, *this);
-    }
+BodyRef ComponentStorage<Body>::operator[](std::size_t index) {
+    return BodyRef(*this, index);
+}
+
+Body ComponentStorage<Body>::operator[](std::size_t index) const {
+    return {densities[index], positions[index], velocities[index],
+        rotations[index], angularVelocities[index], restitutions[index],
+        frictions[index], centersOfMass[index], momentsOfInertia[index],
+        masses[index]};
+}
+
+std::size_t ComponentStorage<Body>::size() const {
+    return positions.size();
+}
+
+void ComponentStorage<Body>::swap(std::size_t i, std::size_t j) {
+    std::swap(densities[i], densities[j]);
+    std::swap(positions[i], positions[j]);
+    std::swap(velocities[i], velocities[j]);
+    std::swap(rotations[i], rotations[j]);
+    std::swap(angularVelocities[i], angularVelocities[j]);
+    std::swap(restitutions[i], restitutions[j]);
+    std::swap(frictions[i], frictions[j]);
+    std::swap(centersOfMass[i], centersOfMass[j]);
+    std::swap(momentsOfInertia[i], momentsOfInertia[j]);
+    std::swap(masses[i], masses[j]);
+}
+
+void ComponentStorage<Body>::erase(std::size_t index) {
+    (*this)[index] = (*this)[size() - 1];
+    densities.pop_back();
+    positions.pop_back();
+    velocities.pop_back();
+    rotations.pop_back();
+    angularVelocities.pop_back();
+    restitutions.pop_back();
+    frictions.pop_back();
+    centersOfMass.pop_back();
+    momentsOfInertia.pop_back();
+    masses.pop_back();
+}
+
+void ComponentStorage<Body>::push_back(const Body& body) {
+    densities.push_back(body.density);
+    positions.push_back(body.position);
+    velocities.push_back(body.velocity);
+    rotations.push_back(body.rotation);
+    angularVelocities.push_back(body.angularVelocity);
+    restitutions.push_back(body.restitution);
+    frictions.push_back(body.friction);
+    centersOfMass.push_back(body.centerOfMass);
+    momentsOfInertia.push_back(body.momentOfInertia);
+    masses.push_back(body.mass);
+}
+
+BodyRef::BodyRef(Body& body):
+    density{body.density},
+    position{body.position},
+    velocity{body.velocity},
+    rotation{body.rotation},
+    angularVelocity{body.angularVelocity},
+    restitution{body.restitution},
+    friction{body.friction},
+    centerOfMass{body.centerOfMass},
+    momentOfInertia{body.momentOfInertia},
+    mass{body.mass} {
+}
+
+BodyRef::BodyRef(ComponentStorage<Body>& storage, std::size_t index):
+    density{storage.densities[index]},
+    position{storage.positions[index]},
+    velocity{storage.velocities[index]},
+    rotation{storage.rotations[index]},
+    angularVelocity{storage.angularVelocities[index]},
+    restitution{storage.restitutions[index]},
+    friction{storage.frictions[index]},
+    centerOfMass{storage.centersOfMass[index]},
+    momentOfInertia{storage.momentsOfInertia[index]},
+    mass{storage.masses[index]} {
+}
+
+BodyRef& BodyRef::operator=(const Body& body) {
+    density = body.density;
+    position = body.position;
+    velocity = body.velocity;
+    rotation = body.rotation;
+    angularVelocity = body.angularVelocity;
+    restitution = body.restitution;
+    friction = body.friction;
+    centerOfMass = body.centerOfMass;
+    momentOfInertia = body.momentOfInertia;
+    mass = body.mass;
+    return *this;
+}
+
+BodyRef& BodyRef::operator=(const BodyRef& other) {
+    return *this = static_cast<Body>(other);
+}
+
+BodyRef::operator Body() const {
+    return {density, position, velocity, rotation, angularVelocity,
+        restitution, friction, centerOfMass, momentOfInertia, mass};
 }
 
-CircleBody::CircleBody(Body& body, float radius_):
+Vector2f BodyRef::localToWorld(const Vector2f& point) const {
+    return rotate(point, rotation) + position;
+}
+
+Vector2f BodyRef::worldToLocal(const Vector2f& point) const {
+    return rotate(point - position, -rotation);
+}
+
+CircleBody::CircleBody(BodyRef body, float radius_):
     radius{radius_} {
     body.mass = pi * radius * radius * body.density;
     body.centerOfMass = {radius, radius};
@@ -32,7 +136,7 @@ std::vector<Vector2f> CircleBody::shadowTerminator(const Vector2f& lightSource,
     return {body.position + orthogonal * radius, body.position - orthogonal * radius};
 }
 
-PolygonBody::PolygonBody(Body& body, const std::vector<Vector2f>& vertices_):
+PolygonBody::PolygonBody(BodyRef body, const std::vector<Vector2f>& vertices_):
     vertices{vertices_} {
     auto triangulation = earClipping(vertices);
 	auto componentIndices = HertelMehlhorn(vertices, triangulation);
@@ -56,16 +160,57 @@ PolygonBody::PolygonBody(Body& body, const std::vector<Vector2f>& vertices_):
     for (ConvexPolygon& component : components) {
         body.momentOfInertia += component.momentOfInertia(body.density, body.centerOfMass);
     }
+    for (ConvexPolygon& component : components) {
+        componentMultipoles.push_back(polygonMultipole(component, body.density));
+        componentMultipoles.back().center -= body.centerOfMass;
+    }
+    multipole = combineMultipoles(componentMultipoles);
+    radius = 0;
+    for (const Vector2f& vertex : vertices) {
+        radius = std::max(radius, norm(vertex - body.centerOfMass));
+    }
+    worldVertices.resize(vertices.size());
+    for (const ConvexPolygon& component : components) {
+        worldComponents.emplace_back(component.getVertices().size());
+    }
 }
 
-std::vector<Vector2f> PolygonBody::shadowTerminator(const Vector2f& lightSource, const Body& body) const {
+void PolygonBody::updateWorldVertices(const Body& body, std::uint64_t tick) {
+    if (hasWorldVertices(tick)) {
+        return;
+    }
+    const Rotation<float> rotation{body.rotation};
+    const auto toWorld = [&] (const Vector2f& v) {
+        return rotate(v - body.centerOfMass, rotation) + body.position;
+    };
+    std::transform(vertices.begin(), vertices.end(), worldVertices.begin(), toWorld);
+    for (std::size_t i{0}; i < components.size(); ++i) {
+        const std::vector<Vector2f>& componentVertices{components[i].getVertices()};
+        std::transform(componentVertices.begin(), componentVertices.end(),
+            worldComponents[i].begin(), toWorld);
+    }
+    worldTick = tick;
+}
+
+bool PolygonBody::hasWorldVertices(std::uint64_t tick) const {
+    return worldTick == tick;
+}
+
+std::vector<Vector2f> PolygonBody::shadowTerminator(const Vector2f& lightSource, const Body& body,
+        bool atWorldVertices) const {
     std::vector<float> angles(vertices.size());
-    std::vector<Vector2f> worldV;
-    std::transform(vertices.begin(), vertices.end(), std::back_inserter(worldV),
-        [&body] (const Vector2f& v) {
-            return body.localToWorld(v - body.centerOfMass);
-        }
-    );
+    // Rendering interpolates the bodies between two steps, so the world
+    // vertices of the last step may not be where the body is drawn
+    std::vector<Vector2f> interpolatedV;
+    if (not atWorldVertices) {
+        const Rotation<float> rotation{body.rotation};
+        std::transform(vertices.begin(), vertices.end(), std::back_inserter(interpolatedV),
+            [&] (const Vector2f& v) {
+                return rotate(v - body.centerOfMass, rotation) + body.position;
+            }
+        );
+    }
+    const std::vector<Vector2f>& worldV{atWorldVertices ? worldVertices : interpolatedV};
     angles[0] = 0.f;
     const float angle0{angle(worldV[0] - lightSource)};
     for (std::size_t i{1}; i < worldV.size(); ++i) {
@@ -89,7 +234,3 @@ std::vector<Vector2f> PolygonBody::shadowTerminator(const Vector2f& lightSource,
     auto [v, b] = intersection(body.position, body.position + n, lightSource, B);
     return {body.position + n * u, body.position + n * v};
 }
-
-Vector2f PolygonBody::supportFunction(const Vector2f& direction, const ConvexPolygon& component, const Body& body) {
-    return body.localToWorld(component.supportFunction(rotate(direction, -body.rotation)) - body.centerOfMass);
-}
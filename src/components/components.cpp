@@ -1,5 +1,16 @@
 #include <components/components.hpp>
 
+void to_json(nlohmann::json& j, const GravitySource& gravitySource) {
+	j = nlohmann::json::object();
+	if (gravitySource.softening > 0) {
+		j["softening"] = gravitySource.softening;
+	}
+}
+
+void from_json(const nlohmann::json& j, GravitySource& gravitySource) {
+	gravitySource.softening = j.value("softening", 0.f);
+}
+
 void to_json(nlohmann::json& j, const SoundEffects& soundEffects) {
     for (auto& [type, data] : soundEffects) {
 		j[nlohmann::json(type).get<std::string>()] = data;
@@ -18,6 +18,10 @@ Vector2f ConvexPolygon::supportFunction(const Vector2f& direction) const {
     return _vertices[std::distance(products.begin(), it)];
 }
 
+const std::vector<Vector2f>& ConvexPolygon::getVertices() const {
+    return _vertices;
+}
+
 
 std::pair<float, Vector2f> ConvexPolygon::areaAndCenterOfMass() const {
 	if (_vertices.size() < 3) {
@@ -38,6 +42,24 @@ std::pair<float, Vector2f> ConvexPolygon::areaAndCenterOfMass() const {
 	return {area, centerOfMass / area};
 }
 
+std::array<float, 3> ConvexPolygon::secondMoments() const {
+    const Vector2f center{areaAndCenterOfMass().second};
+    std::array<float, 3> res{0, 0, 0};
+    const Vector2f A{_vertices[0] - center};
+    for (std::size_t i{1}; i < _vertices.size() - 1; ++i) {
+        const Vector2f B{_vertices[i] - center};
+        const Vector2f C{_vertices[i + 1] - center};
+        // Over a triangle, the integral of x_i x_j is the area / 12 times the
+        // sum of v_i v_j over the vertices plus the product of the sums
+        const float area{std::abs(cross(B - A, C - A)) / 2.f};
+        const Vector2f sum{A + B + C};
+        res[0] += area / 12.f * (A.x * A.x + B.x * B.x + C.x * C.x + sum.x * sum.x);
+        res[1] += area / 12.f * (A.x * A.y + B.x * B.y + C.x * C.y + sum.x * sum.y);
+        res[2] += area / 12.f * (A.y * A.y + B.y * B.y + C.y * C.y + sum.y * sum.y);
+    }
+    return res;
+}
+
 float ConvexPolygon::momentOfInertia(float density, const Vector2f& axis) const {
     float momentOfInertia{0};
     float area{0};
@@ -41,10 +41,11 @@ GameState::GameState(StateStack& stack,
     _collisionSystem{_scene},
     _gameplaySystem{_scene},
     _lightSystem{_scene, _canvas->getRenderTexture(), shaderManager.get("light")},
-    _physicsSystem{_scene},
+    _physicsSystem{_scene, settings.physicsSettings},
     _renderSystem{_scene},
     _soundEffectsSystem{_scene, settings.soundSettings},
     _thermodynamicsSystem{_scene},
+    _trajectoryPredictor{settings.physicsSettings},
     _serializer{_scene, textureManager, tguiTextureManager, soundBufferManager} {
     registerComponents();
     // TODO Display a message when the save is invalid (e.g. JSON error), rather than crashing
@@ -62,12 +63,16 @@ bool GameState::update(sf::Time dt) {
     processtriggerEventsQueue();
     // Update systems
     _collisionSystem.update();
-    _lightSystem.update();
     _animationSystem.update(dt);
     _physicsSystem.update(dt);
-    _renderSystem.update();
+    _trajectoryPredictor.update(_scene, _physicsSystem);
+    _lightSystem.update(_physicsSystem);
+    _renderSystem.update(_physicsSystem);
     _gameplaySystem.update(dt);
     _thermodynamicsSystem.update(dt);
+    // Apply the structural changes requested by the systems, now that none of
+    // them is iterating on the scene
+    _scene.commands().apply();
     // Update the view
     updateView(1.f, false, dt);
     // Draw on the canvas
@@ -125,7 +130,8 @@ bool GameState::handleEvent(const sf::Event& sfEvent) {
         } else if (start) {
             switch (input) {
             case GameInput::ToggleMap:
-                _stack.pushState<MapState>(_scene);
+                _stack.pushState<MapState, Scene&, const PhysicsSystem&,
+                    const TrajectoryPredictor&>(_scene, _physicsSystem, _trajectoryPredictor);
                 consumed = true;
                 break;
             case GameInput::Pause:
@@ -166,19 +172,25 @@ void GameState::registerComponents() {
     _scene.registerComponent<SoundEffects>();
     _scene.registerComponent<Animations>();
     _scene.registerComponent<LightSource>();
+    _scene.registerComponent<GravitySource>();
     _scene.registerComponent<Player>();
     _scene.registerComponent<MapElement>();
     _scene.registerComponent<Sprite>();
+    // Polygon bodies are created and destroyed more often, so their group is
+    // registered last to make these changes cheaper.
+    _scene.registerGroup<Body, CircleBody>();
+    _scene.registerGroup<Body, PolygonBody>();
 }
 
 void GameState::updateView(float zoom, bool rotate, sf::Time dt) {
-    const Body& playerBody{_scene.getComponent<Body>(_scene.findUnique<Player>())};
+    const EntityId playerId{_scene.findUnique<Player>()};
+    const BodyRef playerBody{_scene.getComponent<Body>(playerId)};
     sf::View view{_canvas->getRenderTexture().getView()};
     const Vector2f viewSize{view.getSize() * zoom};
     view.setSize(clampVector(viewSize, _minViewSize, _maxViewSize));
-    view.setCenter(playerBody.position);
+    view.setCenter(_physicsSystem.interpolatePosition(playerId, playerBody.position));
     if (rotate) {
-        float target{playerBody.rotation};
+        float target{_physicsSystem.interpolateRotation(playerId, playerBody.rotation)};
         float current{degToRad(view.getRotation())};
         if (target - current > pi) {
             current += 2.f * pi;
@@ -212,6 +224,11 @@ void GameState::processtriggerEventsQueue() {
         const Event& event{_eventQueue.front()};
         _animationSystem.handleEvent(event);
         _soundEffectsSystem.handleEvent(event);
+        // Thrusting and colliding change the trajectories on the map
+        _trajectoryPredictor.invalidate(event.entity);
+        if (const auto* collision = std::get_if<Event::CollisionEvent>(&event.data)) {
+            _trajectoryPredictor.invalidate(collision->otherEntity);
+        }
         _eventQueue.pop();
     }
 }
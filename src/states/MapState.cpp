@@ -3,6 +3,8 @@
 #include <TGUI/Texture.hpp>
 #include <states/StateStack.hpp>
 #include <states/MapState.hpp>
+#include <systems/PhysicsSystem.hpp>
+#include <TrajectoryPredictor.hpp>
 #include <Scene.hpp>
 #include <Settings.hpp>
 #include <ResourceManager.hpp>
@@ -13,36 +15,51 @@ MapState::MapState(
         StateStack& stack,
         ResourceManager<tgui::Texture>& tguiTextureManager,
         const Settings& settings,
-        Scene& scene):
+        Scene& scene,
+        const PhysicsSystem& physicsSystem,
+        const TrajectoryPredictor& trajectoryPredictor):
     AbstractState{stack},
     _tguiTextureManager{tguiTextureManager},
     _scene{scene},
+    _physicsSystem{physicsSystem},
+    _trajectoryPredictor{trajectoryPredictor},
     _inputManager{settings.mapKeyboardMapping, settings.mapControllerMapping},
     _background{tgui::Picture::create(_tguiTextureManager.get("mapBackground"))} {
 }
 
 tgui::Widget::Ptr MapState::buildGui() {
-    for (auto& [id, mapElement] : _scene.view<MapElement>()) {
+    for (auto [id, mapElement] : _scene.view<MapElement>()) {
         _mapIcons->add(mapElement.icon);
     }
     tgui::Group::Ptr group{tgui::Group::create()};
     group->add(_background);
+    group->add(_trajectoryCanvas);
     group->add(_mapIcons);
     return group;
 }
 
 bool MapState::update(sf::Time dt) {
-    const Body& playerBody{_scene.getComponent<Body>(_scene.findUnique<Player>())};
-    const Vector2f playerPos{playerBody.position};
+    const EntityId playerId{_scene.findUnique<Player>()};
+    const BodyRef playerBody{_scene.getComponent<Body>(playerId)};
+    const Vector2f playerPos{_physicsSystem.interpolatePosition(playerId, playerBody.position)};
     const Vector2f mapSize{_mapIcons->getSize()};
+    // The bodies moved by the last physics step are interpolated, so they
+    // move at each frame until the next step
+    const std::uint64_t since{std::min(_lastTick, _physicsSystem.getInterpolationTick())};
+    _lastTick = _scene.advanceTick();
+    // The icons are placed relatively to the player, so they all move when
+    // the player or the view changes. Otherwise only the changed ones move.
+    const bool updateAll{_viewChanged or _scene.hasChanged<Body>(playerId, since)};
+    _viewChanged = false;
 
-    for (auto& [id, body, mapElement] : _scene.view<Body, MapElement>()) {
+    for (auto [id, body, mapElement] : _scene.changed<Body, MapElement>(updateAll ? 0 : since)) {
         // Compute the position of the map element on the screen.
-        Vector2f screenPos{(body.position - playerPos) / _scale};
+        Vector2f screenPos{(_physicsSystem.interpolatePosition(id, body.position) - playerPos) / _scale};
         screenPos += mapSize / 2.f;
         mapElement.icon->setPosition(static_cast<tgui::Vector2f>(screenPos));
-        mapElement.icon->setRotation(radToDeg(body.rotation));
+        mapElement.icon->setRotation(radToDeg(_physicsSystem.interpolateRotation(id, body.rotation)));
     }
+    drawTrajectories(playerPos);
     handleContinuousInputs(dt);
     return false;
 }
@@ -50,6 +67,9 @@ bool MapState::update(sf::Time dt) {
 bool MapState::handleEvent(const sf::Event& event) {
     std::vector<std::pair<MapInput, bool>> inputEvents{_inputManager.getInputEvents(event)};
     bool consumed{false};
+    if (event.type == sf::Event::Resized) {
+        _viewChanged = true;
+    }
     for (auto& [input, start] : inputEvents) {
         if (start and input == MapInput::Exit) {
             _stack.popStatesUntil(*this);
@@ -62,10 +82,39 @@ bool MapState::handleEvent(const sf::Event& event) {
 bool MapState::handleContinuousInputs(sf::Time dt) {
     if (_inputManager.isActivated(MapInput::ZoomIn)) {
         _scale *= std::pow(_zoomSpeed, dt.asSeconds());
+        _viewChanged = true;
     }
     if (_inputManager.isActivated(MapInput::ZoomOut)) {
         _scale /= std::pow(_zoomSpeed, dt.asSeconds());
+        _viewChanged = true;
     }
     _scale = std::clamp(_scale, _minScale, _maxScale);
     return false;
 }
+
+void MapState::drawTrajectories(const Vector2f& playerPos) {
+    const std::shared_ptr<const TrajectoryPredictor::Prediction> prediction{_trajectoryPredictor.getPrediction()};
+    if (prediction and prediction->generation != _trajectoryGeneration) {
+        _trajectoryGeneration = prediction->generation;
+        _trajectories.clear();
+        for (std::size_t k{0}; k < prediction->entities.size(); ++k) {
+            const EntityId id{prediction->entities[k]};
+            if (not _scene.isValid(id) or not _scene.hasComponent<MapElement>(id)) {
+                continue;
+            }
+            sf::VertexArray& trajectory{_trajectories.emplace_back(sf::LineStrip)};
+            for (std::size_t i{prediction->offsets[k]}; i < prediction->offsets[k + 1]; ++i) {
+                trajectory.append(sf::Vertex(prediction->points[i], _trajectoryColor));
+            }
+        }
+    }
+    // Same placement as the icons, relatively to the player
+    const Vector2f mapSize{_mapIcons->getSize()};
+    sf::Transform transform;
+    transform.translate(mapSize / 2.f).scale(1.f / _scale, 1.f / _scale).translate(-playerPos);
+    _trajectoryCanvas->clear(sf::Color::Transparent);
+    for (const sf::VertexArray& trajectory : _trajectories) {
+        _trajectoryCanvas->draw(trajectory, sf::RenderStates(transform));
+    }
+    _trajectoryCanvas->display();
+}
@@ -13,7 +13,7 @@ AnimationSystem::AnimationSystem(Scene& scene, const SoundSettings& soundSetting
 }
 
 void AnimationSystem::update(sf::Time dt) {
-    for (auto& [id, animations] : _scene.view<Animations>()) {
+    for (auto [id, animations] : _scene.view<Animations>()) {
         for (auto& [type, data] : animations) {
             data.animation.setVolume(_soundSettings.mainVolume * _soundSettings.effectsVolume / 100);
             if (not data.animation.isStopped()) {
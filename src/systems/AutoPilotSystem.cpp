@@ -34,7 +34,7 @@ std::queue<Event> AutoPilotSystem::queueEvents() {
     }
 
     // Check if the RCS should start or stop
-    const Body& playerBody{_scene.getComponent<Body>(playerId)};
+    const BodyRef playerBody{_scene.getComponent<Body>(playerId)};
     const float threshold{player.angularVelocityThreshold};
     if (playerBody.angularVelocity > threshold and not player.autoControls.rcsCounterClockwise) {
         // Start RCS counterclockwise
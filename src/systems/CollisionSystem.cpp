@@ -1,55 +1,87 @@
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
 #include <systems/CollisionSystem.hpp>
 #include <components/Body.hpp>
 #include <Scene.hpp>
 #include <Event.hpp>
-
-using namespace std::placeholders;
+#include <SupportFunctions.hpp>
 
 CollisionSystem::CollisionSystem(Scene& scene):
     _scene{scene} {
 }
 
 void CollisionSystem::update() {
-    auto polygonView = _scene.view<Body, PolygonBody>();
-    auto circleView = _scene.view<Body, CircleBody>();
-
-    for (std::size_t i{0}; i < circleView.size(); ++i) {
-        auto& [idA, bodyA, circleA] = circleView[i];
-        // Circle - circle collisions
-        for (std::size_t j{i + 1}; j < circleView.size(); ++j) {
-            auto& [idB, bodyB, circleB] = circleView[j];
-            collideCircles(idA, idB, circleA, circleB, bodyA, bodyB);
-        }
-        // Circle - polygon collisions
-        for (std::size_t j{0}; j < polygonView.size(); ++j) {
-            auto& [idB, bodyB, polygonB] = polygonView[j];
-            for (const ConvexPolygon& componentB : polygonB.components) {
-                SupportFunction functionB{std::bind(
-                    &PolygonBody::supportFunction,
-                    _1, std::cref(componentB), std::cref(bodyB))};
-                collideCircleAndConvex(idA, idB, circleA, functionB, bodyA, bodyB);
+    auto polygonGroup = _scene.group<Body, PolygonBody>();
+    auto circleGroup = _scene.group<Body, CircleBody>();
+
+    // Bounding boxes in world coordinates, for the broad phase
+    _colliders.clear();
+    _boxes.clear();
+    for (auto [id, body, circle] : circleGroup) {
+        const Vector2f extent{circle.radius, circle.radius};
+        _colliders.push_back({id, &circle, nullptr, 0});
+        _boxes.push_back({body.position - extent, body.position + extent});
+    }
+    for (auto [id, body, polygon] : polygonGroup) {
+        // Usually a no-op, the physics moved the world vertices already
+        polygon.updateWorldVertices(body, _scene.changeTick<Body>(id));
+        for (std::uint32_t i{0}; i < polygon.worldComponents.size(); ++i) {
+            SweepAndPrune::Box box{
+                {std::numeric_limits<float>::max(), std::numeric_limits<float>::max()},
+                {std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest()}};
+            for (const Vector2f& world : polygon.worldComponents[i]) {
+                box.min = {std::min(box.min.x, world.x), std::min(box.min.y, world.y)};
+                box.max = {std::max(box.max.x, world.x), std::max(box.max.y, world.y)};
             }
+            _colliders.push_back({id, nullptr, &polygon, i});
+            _boxes.push_back(box);
         }
     }
-
-    for (std::size_t i{0}; i < polygonView.size(); ++i) {
-        auto& [idA, bodyA, polygonA] = polygonView[i];
-        // Polygon - polygon collisions
-        for (std::size_t j{i + 1}; j < polygonView.size(); ++j) {
-            auto& [idB, bodyB, polygonB] = polygonView[j];
-            for (const ConvexPolygon& componentA : polygonA.components) {
-                for (const ConvexPolygon& componentB : polygonB.components) {
-                    SupportFunction functionA{std::bind(
-                        &PolygonBody::supportFunction,
-                        _1, std::cref(componentA), std::cref(bodyA))};
-                    SupportFunction functionB{std::bind(
-                        &PolygonBody::supportFunction,
-                        _1, std::cref(componentB), std::cref(bodyB))};
-                    collideConvexes(idA, idB, functionA, functionB, bodyA, bodyB);
-                }
-            }
+    _broadPhase.update(_boxes);
+
+    // Narrow phase, only on the pairs of overlapping boxes
+    ++_frame;
+    for (auto [a, b] : _broadPhase.getPairs()) {
+        const Collider& colliderA{_colliders[a]};
+        const Collider& colliderB{_colliders[b]};
+        if (colliderA.id == colliderB.id) {
+            // Components of the same polygon
+            continue;
+        }
+        BodyRef bodyA{_scene.getComponent<Body>(colliderA.id)};
+        BodyRef bodyB{_scene.getComponent<Body>(colliderB.id)};
+        if (colliderB.circle != nullptr) {
+            // Circle - circle collisions
+            collideCircles(colliderA.id, colliderB.id, *colliderA.circle, *colliderB.circle, bodyA, bodyB);
+            continue;
         }
+        ContactCache& cache{_contactCache[{
+            (std::uint64_t{colliderA.id} << 32) | colliderA.componentIndex,
+            (std::uint64_t{colliderB.id} << 32) | colliderB.componentIndex}]};
+        cache.frame = _frame;
+        // The collisions of the previous pairs may have moved the bodies
+        colliderB.polygon->updateWorldVertices(bodyB, _scene.changeTick<Body>(colliderB.id));
+        withConvexSupport(colliderB.polygon->worldComponents[colliderB.componentIndex],
+                [&](const auto& functionB) {
+            if (colliderA.circle != nullptr) {
+                // Circle - polygon collisions
+                collideCircleAndConvex(colliderA.id, colliderB.id, *colliderA.circle, functionB, bodyA, bodyB, cache);
+                return;
+            }
+            // Polygon - polygon collisions
+            colliderA.polygon->updateWorldVertices(bodyA, _scene.changeTick<Body>(colliderA.id));
+            withConvexSupport(colliderA.polygon->worldComponents[colliderA.componentIndex],
+                    [&](const auto& functionA) {
+                collideConvexes(colliderA.id, colliderB.id, functionA, functionB, bodyA, bodyB, cache);
+            });
+        });
     }
+    // Pairs that are not close anymore, or whose entities are gone
+    std::erase_if(_contactCache, [this](const auto& entry) {
+        return entry.second.frame != _frame;
+    });
 }
 
 std::queue<Event> CollisionSystem::queueEvents() {
@@ -58,14 +90,22 @@ std::queue<Event> CollisionSystem::queueEvents() {
     return res;
 }
 
+std::size_t CollisionSystem::getContactCacheSize() const {
+    return _contactCache.size();
+}
+
+template <typename SupportA, typename SupportB>
 void CollisionSystem::collideConvexes(EntityId idA, EntityId idB,
-        const SupportFunction& functionA, const SupportFunction& functionB,
-        Body& bodyA, Body& bodyB) {
+        const SupportA& functionA, const SupportB& functionB,
+        BodyRef bodyA, BodyRef bodyB, ContactCache& cache) {
     // Determine if the bodies collide with GJK
-    std::pair<bool, MinkowskyPolygon> collision{collisionGJK(functionA, functionB)};
-    if (collision.first) {
+    std::pair<bool, MinkowskyPolygon> collision{collisionGJK(functionA, functionB, cache.direction)};
+    if (not collision.first) {
+        cache.collided = false;
+    } else {
         // Determine the collision info with EPA
-        ContactInfo contactInfo{EPA(functionA, functionB, collision.second)};
+        ContactInfo contactInfo{EPA(functionA, functionB, collision.second, cache.normal, cache.collided)};
+        cache.collided = true;
         // Update the bodies' speed, position and rotation according to the collision
         collisionResponse(idA, idB, bodyA, bodyB, contactInfo);
     }
@@ -73,7 +113,7 @@ void CollisionSystem::collideConvexes(EntityId idA, EntityId idB,
 
 void CollisionSystem::collideCircles(EntityId idA, EntityId idB,
         const CircleBody& circleA, const CircleBody& circleB,
-        Body& bodyA, Body& bodyB) {
+        BodyRef bodyA, BodyRef bodyB) {
     const Vector2f diff_x = bodyB.position - bodyA.position;
     const float dist{norm(diff_x)};
     const float overlap{circleA.radius + circleB.radius - dist};
@@ -94,20 +134,26 @@ void CollisionSystem::collideCircles(EntityId idA, EntityId idB,
         // The displacement is proportional to the mass of the other body.
         bodyA.position -= m_b * overlap * diff_x / (dist * (m_a + m_b));
         bodyB.position += m_a * overlap * diff_x / (dist * (m_a + m_b));
+        // As in collisionResponse, each collision changes the bodies in a
+        // new tick
+        _scene.advanceTick();
+        _scene.markChanged<Body>(idA);
+        _scene.markChanged<Body>(idB);
 
         _collisionEvents.emplace(idA, true, Event::CollisionEvent(norm(addedVel), idB));
     }
 }
 
+template <typename SupportB>
 void CollisionSystem::collideCircleAndConvex(EntityId idA, EntityId idB,
-        const CircleBody& circleA, const SupportFunction& functionB,
-        Body& bodyA, Body& bodyB) {
+        const CircleBody& circleA, const SupportB& functionB,
+        BodyRef bodyA, BodyRef bodyB, ContactCache& cache) {
     // Check the distance between B and the center of A
-    const Vector2f centerA{bodyA.localToWorld({0, 0})};
-    SupportFunction functionA = [centerA](const Vector2f&) noexcept {return centerA;};
-    std::pair<bool, MinkowskyPolygon> collision{collisionGJK(functionA, functionB)};
+    const PointSupport functionA{bodyA.position};
+    std::pair<bool, MinkowskyPolygon> collision{collisionGJK(functionA, functionB, cache.direction)};
     // If the center of A is not in B
     if (not collision.first) {
+        cache.collided = false;
         // Find the distance between B and the center of A
         ContactInfo distanceInfo{distanceGJK(functionA, functionB, collision.second)};
         assert(distanceInfo.distance >= 0);
@@ -122,7 +168,8 @@ void CollisionSystem::collideCircleAndConvex(EntityId idA, EntityId idB,
     } else {
         // The center of A is in B, use EPA to find the collision vector, and
         // increase it to clear the whole circle A from B.
-        ContactInfo contactInfo{EPA(functionA, functionB, collision.second)};
+        ContactInfo contactInfo{EPA(functionA, functionB, collision.second, cache.normal, cache.collided)};
+        cache.collided = true;
         contactInfo.C_A += contactInfo.normal * circleA.radius;
         contactInfo.distance -= circleA.radius;
         collisionResponse(idA, idB, bodyA, bodyB, contactInfo);
@@ -130,7 +177,7 @@ void CollisionSystem::collideCircleAndConvex(EntityId idA, EntityId idB,
 }
 
 void CollisionSystem::collisionResponse(EntityId idA, EntityId idB,
-        Body& bodyA, Body& bodyB, const ContactInfo& contactInfo) {
+        BodyRef bodyA, BodyRef bodyB, const ContactInfo& contactInfo) {
     // Vector going from the center of mass to the contact point.
     // We don't use Body::worldToLocal because we need to keep the angle.
     assert(std::abs(norm(contactInfo.normal) - 1) < eps);
@@ -173,6 +220,11 @@ void CollisionSystem::collisionResponse(EntityId idA, EntityId idB,
     // Shift the bodies out of collision. Note that we have a negative signed distance
     bodyA.position += contactInfo.normal * contactInfo.distance * bodyB.mass / (bodyA.mass + bodyB.mass);
     bodyB.position -= contactInfo.normal * contactInfo.distance * bodyA.mass / (bodyA.mass + bodyB.mass);
+    // Each response changes the bodies in a new tick, so that the world
+    // vertices of a body moved by several collisions are updated each time
+    _scene.advanceTick();
+    _scene.markChanged<Body>(idA);
+    _scene.markChanged<Body>(idB);
 
     _collisionEvents.emplace(idA, true, Event::CollisionEvent(norm(J), idB));
 }
@@ -182,13 +234,23 @@ void CollisionSystem::MinkowskyPolygon::pushBack(const Vector2f& A, const Vector
 }
 
 void CollisionSystem::MinkowskyPolygon::insert(std::size_t index, const Vector2f& A, const Vector2f& B) {
-    _pointsA.insert(_pointsA.begin() + index, A);
-    _pointsB.insert(_pointsB.begin() + index, B);
+    assert(index <= _size and _size < capacity);
+    for (std::size_t i{_size}; i > index; --i) {
+        _pointsA[i] = _pointsA[i - 1];
+        _pointsB[i] = _pointsB[i - 1];
+    }
+    _pointsA[index] = A;
+    _pointsB[index] = B;
+    ++_size;
 }
 
 void CollisionSystem::MinkowskyPolygon::erase(std::size_t index) {
-    _pointsA.erase(_pointsA.begin() + index);
-    _pointsB.erase(_pointsB.begin() + index);
+    assert(index < _size);
+    for (std::size_t i{index}; i + 1 < _size; ++i) {
+        _pointsA[i] = _pointsA[i + 1];
+        _pointsB[i] = _pointsB[i + 1];
+    }
+    --_size;
 }
 
 Vector2f CollisionSystem::MinkowskyPolygon::getDifference(std::size_t index) const {
@@ -196,22 +258,139 @@ Vector2f CollisionSystem::MinkowskyPolygon::getDifference(std::size_t index) con
 }
 
 Vector2f CollisionSystem::MinkowskyPolygon::getPointA(std::size_t index) const {
-    return _pointsA.at(index);
+    assert(index < _size);
+    return _pointsA[index];
 }
 
 Vector2f CollisionSystem::MinkowskyPolygon::getPointB(std::size_t index) const {
-    return _pointsB.at(index);
+    assert(index < _size);
+    return _pointsB[index];
 }
 
 std::size_t CollisionSystem::MinkowskyPolygon::size() const {
-    return _pointsA.size();
+    return _size;
+}
+
+std::size_t CollisionSystem::ContactKeyHash::operator()(const ContactKey& key) const {
+    const std::hash<std::uint64_t> hash;
+    return hash(key.a) ^ (hash(key.b) * 0x9e3779b97f4a7c15ULL);
+}
+
+CollisionSystem::Polytope::Polytope(const MinkowskyPolygon& simplex) {
+    _size = simplex.size();
+    for (std::size_t i{0}; i < _size; ++i) {
+        _pointsA[i] = simplex.getPointA(i);
+        _pointsB[i] = simplex.getPointB(i);
+        _next[i] = static_cast<std::uint8_t>((i + 1) % _size);
+    }
+    for (std::size_t i{0}; i < _size; ++i) {
+        pushEdge(i);
+    }
+}
+
+std::size_t CollisionSystem::Polytope::closestEdge() {
+    const auto further = [](const HeapEntry& a, const HeapEntry& b) {
+        return a.distance > b.distance;
+    };
+    // Drop the edges that were split since they were pushed
+    while (_next[_heap[0].start] != _heap[0].end) {
+        std::pop_heap(_heap.begin(), _heap.begin() + _heapSize, further);
+        --_heapSize;
+        assert(_heapSize > 0);
+    }
+    return _heap[0].start;
+}
+
+float CollisionSystem::Polytope::getDistance(std::size_t edge) const {
+    return _distances[edge];
+}
+
+Vector2f CollisionSystem::Polytope::getNormal(std::size_t edge) const {
+    return _normals[edge];
 }
 
+std::size_t CollisionSystem::Polytope::next(std::size_t vertex) const {
+    return _next[vertex];
+}
+
+void CollisionSystem::Polytope::split(std::size_t edge, const Vector2f& A, const Vector2f& B) {
+    assert(not isFull());
+    const std::size_t vertex{_size++};
+    _pointsA[vertex] = A;
+    _pointsB[vertex] = B;
+    _next[vertex] = _next[edge];
+    _next[edge] = static_cast<std::uint8_t>(vertex);
+    pushEdge(edge);
+    pushEdge(vertex);
+}
+
+void CollisionSystem::Polytope::insert(const Vector2f& A, const Vector2f& B) {
+    const Vector2f D{A - B};
+    std::size_t i{0};
+    for (std::size_t k{0}; k < _size; ++k, i = _next[i]) {
+        const Vector2f D_i{getDifference(i)}, D_j{getDifference(_next[i])};
+        if (norm2(D - D_i) < eps * eps) {
+            return;
+        }
+        // Between D_i and D_j seen from the origin, and beyond the edge
+        const float winding{cross(D_i, D_j)};
+        if (cross(D_i, D) * winding >= 0 and cross(D, D_j) * winding >= 0) {
+            if (dot(D - D_i, _normals[i]) > eps and not isFull()) {
+                split(i, A, B);
+            }
+            return;
+        }
+    }
+}
+
+bool CollisionSystem::Polytope::isFull() const {
+    return _size == capacity;
+}
+
+Vector2f CollisionSystem::Polytope::getDifference(std::size_t index) const {
+    return getPointA(index) - getPointB(index);
+}
+
+Vector2f CollisionSystem::Polytope::getPointA(std::size_t index) const {
+    assert(index < _size);
+    return _pointsA[index];
+}
+
+Vector2f CollisionSystem::Polytope::getPointB(std::size_t index) const {
+    assert(index < _size);
+    return _pointsB[index];
+}
+
+void CollisionSystem::Polytope::pushEdge(std::size_t edge) {
+    const Vector2f D_i{getDifference(edge)}, D_j{getDifference(_next[edge])};
+    Vector2f normal{perpendicular(D_j - D_i, D_i)};
+    const float length{norm(normal)};
+    // A degenerate edge is never the closest one
+    float distance{std::numeric_limits<float>::max()};
+    if (length > 0) {
+        normal /= length;
+        distance = dot(normal, D_i);
+    }
+    _distances[edge] = distance;
+    _normals[edge] = normal;
+    _heap[_heapSize++] = {distance, static_cast<std::uint8_t>(edge), _next[edge]};
+    std::push_heap(_heap.begin(), _heap.begin() + _heapSize, [](const HeapEntry& a, const HeapEntry& b) {
+        return a.distance > b.distance;
+    });
+}
+
+template <typename SupportA, typename SupportB>
 std::pair<bool, CollisionSystem::MinkowskyPolygon> CollisionSystem::collisionGJK(
-            const SupportFunction& functionA, const SupportFunction& functionB) {
+            const SupportA& functionA, const SupportB& functionB, Vector2f& direction) {
     // GJK algorithm, see https://blog.winter.dev/2020/gjk-algorithm/
 	// Or even better: https://youtu.be/ajv46BSqcK4
-    Vector2f direction{1, 0};
+    // Starting from the last direction of the previous frame, the first
+    // support point is close to the closest point to the origin, so a pair
+    // still apart is found in one iteration.
+    // Shapes that touched leave a null direction, which has no support point
+    if (not (norm2(direction) > 0)) {
+        direction = {1, 0};
+    }
     Vector2f supportA{functionA(direction)};
     Vector2f supportB{functionB(-direction)};
     Vector2f supportPoint{supportA - supportB};
@@ -237,8 +416,9 @@ std::pair<bool, CollisionSystem::MinkowskyPolygon> CollisionSystem::collisionGJK
     return {false, simplex};
 }
 
-CollisionSystem::ContactInfo CollisionSystem::distanceGJK(const SupportFunction& functionA,
-        const SupportFunction& functionB, CollisionSystem::MinkowskyPolygon simplex) {
+template <typename SupportA, typename SupportB>
+CollisionSystem::ContactInfo CollisionSystem::distanceGJK(const SupportA& functionA,
+        const SupportB& functionB, CollisionSystem::MinkowskyPolygon simplex) {
     assert(simplex.size() == 2 or simplex.size() == 3);
 
     // Special case: if the simplex contains only the closest point already
@@ -277,34 +457,28 @@ CollisionSystem::ContactInfo CollisionSystem::distanceGJK(const SupportFunction&
     return ContactInfo();
 }
 
-CollisionSystem::ContactInfo CollisionSystem::EPA(const SupportFunction& functionA,
-        const SupportFunction& functionB, CollisionSystem::MinkowskyPolygon polygon) {
-    assert(polygon.size() == 3);
+template <typename SupportA, typename SupportB>
+CollisionSystem::ContactInfo CollisionSystem::EPA(const SupportA& functionA,
+        const SupportB& functionB, CollisionSystem::MinkowskyPolygon simplex, Vector2f& normal,
+        bool warmStart) {
+    assert(simplex.size() == 3);
+    Polytope polytope{simplex};
+    // The closest edge of the previous frame is usually still the closest
+    // one. Its vertices are the support points in directions slightly tilted
+    // from its normal, so with them EPA stops after one iteration.
+    if (warmStart) {
+        const Vector2f tilt{perpendicular(normal, true) * 0.01f};
+        polytope.insert(functionA(normal + tilt), functionB(-normal - tilt));
+        polytope.insert(functionA(normal - tilt), functionB(-normal + tilt));
+    }
 
     std::size_t maxIter{100};
     for (std::size_t t{0}; t < maxIter; ++t) {
         // Find the polygon edge closest to the origin, and the associated
         // normal vector pointing away from the origin.
-        // TODO we could cache the results of previous iteration, since at most
-        // two edges are added to the polygon each iteration.
-        float minDistance{std::numeric_limits<float>::max()};
-        Vector2f minNormal;
-        std::size_t minIndex;
-        bool found{false};
-        for (std::size_t i{0}; i < polygon.size(); ++i) {
-            std::size_t j{(i + 1) % polygon.size()};
-            Vector2f D_i{polygon.getDifference(i)}, D_j{polygon.getDifference(j)};
-            Vector2f normal{perpendicular(D_j - D_i, D_i)};
-            float distance{dot(normal, D_i)};
-            normal /= norm(normal);
-            if (distance < minDistance) {
-                minDistance = distance;
-                minNormal = normal;
-                minIndex = i;
-                found = true;
-            }
-        }
-        assert(found);
+        const std::size_t edge{polytope.closestEdge()};
+        const float minDistance{polytope.getDistance(edge)};
+        const Vector2f minNormal{polytope.getNormal(edge)};
 
         // Find the support point in the direction of the normal, and check
         // if this point is further
@@ -313,21 +487,23 @@ CollisionSystem::ContactInfo CollisionSystem::EPA(const SupportFunction& functio
         float supportDistance{dot(supportA - supportB, minNormal)};
 
         // If the point is no further, we found the closest edge.
-        // We also stop here if we are at the end of the loop
-        if (std::abs(supportDistance - minDistance) <= eps or t == maxIter - 1) {
-            std::size_t j{(minIndex + 1) % polygon.size()};
-            return createContactInfo(polygon, minIndex, j, true);
+        // We also stop here if we are at the end of the loop, or if the
+        // polytope is full
+        if (std::abs(supportDistance - minDistance) <= eps or t == maxIter - 1 or polytope.isFull()) {
+            normal = minNormal;
+            return createContactInfo(polytope, edge, polytope.next(edge), true);
         }
         // Otherwise, add the point to the polygon
-        polygon.insert((minIndex + 1) % polygon.size(), supportA, supportB);
+        polytope.split(edge, supportA, supportB);
     }
     // Unreachable code
     assert(false);
     return ContactInfo();
 }
 
+template <typename Polygon>
 CollisionSystem::ContactInfo CollisionSystem::createContactInfo(
-        const CollisionSystem::MinkowskyPolygon& simplex,
+        const Polygon& simplex,
         std::size_t i, std::size_t j, bool inside) {
     // Find the four points in A and B which correspond to the current
     // edge of the the polygon
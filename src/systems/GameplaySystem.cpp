@@ -9,7 +9,7 @@ GameplaySystem::GameplaySystem(Scene& scene):
 }
 
 void GameplaySystem::update(sf::Time dt) {
-    for (auto& [id, player, body] : _scene.view<Player, Body>()) {
+    for (auto [id, player, body] : _scene.view<Player, Body>()) {
         Vector2f dv{0, 0};
         float dw{0};
         const float engineAccel{200};
@@ -38,5 +38,6 @@ void GameplaySystem::update(sf::Time dt) {
         }
         body.velocity += rotate(dv, body.rotation) * dt.asSeconds();
         body.angularVelocity += dw * dt.asSeconds();
+        _scene.markChanged<Body>(id);
     }
 }
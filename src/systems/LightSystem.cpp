@@ -4,6 +4,7 @@
 #include <SFML/Graphics/RenderTarget.hpp>
 #include <SFML/Graphics/ConvexShape.hpp>
 #include <systems/LightSystem.hpp>
+#include <systems/PhysicsSystem.hpp>
 #include <Scene.hpp>
 #include <components/Body.hpp>
 #include <components/components.hpp>
@@ -15,7 +16,7 @@ LightSystem::LightSystem(Scene& scene, const sf::RenderTarget& renderTarget, sf:
     _renderTexture.create(1, 1);
 }
 
-void LightSystem::update() {
+void LightSystem::update(const PhysicsSystem& physics) {
     const Vector2u uScreenSize(_renderTarget.getSize());
     _screenSize = static_cast<Vector2f>(uScreenSize);
 
@@ -23,7 +24,7 @@ void LightSystem::update() {
         _renderTexture.create(uScreenSize.x, uScreenSize.y);
     }
 
-    auto shadowShapes = computeShadowShapes();
+    auto shadowShapes = computeShadowShapes(physics);
 
     _renderTexture.clear(sf::Color::White);
     for (auto& shadowShape : shadowShapes) {
@@ -37,7 +38,7 @@ void LightSystem::update() {
     _shader.setUniform("screenSize", _screenSize);
 }
 
-std::vector<sf::ConvexShape> LightSystem::computeShadowShapes() {
+std::vector<sf::ConvexShape> LightSystem::computeShadowShapes(const PhysicsSystem& physics) {
     int w(_renderTarget.getSize().x), h(_renderTarget.getSize().y);
     std::vector<Vector2i> corners{{0, 0}, {w, 0}, {w, h}, {0, h}};
     std::array<Vector2f, 4> viewArray;
@@ -45,34 +46,57 @@ std::vector<sf::ConvexShape> LightSystem::computeShadowShapes() {
         viewArray[i] = _renderTarget.mapPixelToCoords(corners[i]);
     }
 
-    // Fetch the list of shadow entities in advance to avoid repeating the call
-    // in the loop
-    auto shadowView = _scene.view<Body>();
+    auto circleGroup = _scene.group<Body, CircleBody>();
+    auto polygonGroup = _scene.group<Body, PolygonBody>();
     std::vector<sf::ConvexShape> shadowShapes;
-    for (auto& [lightId, lightBody, _ignored_] : _scene.view<Body, LightSource>()) {
-        const Vector2f lightSource{lightBody.position};
+    // Shadows follow the bodies as they are rendered, between two physics
+    // steps
+    const auto interpolate = [&physics](EntityId id, Body body) {
+        body.position = physics.interpolatePosition(id, body.position);
+        body.rotation = physics.interpolateRotation(id, body.rotation);
+        return body;
+    };
+    for (auto [lightId, lightBody, _ignored_] : _scene.view<Body, LightSource>()) {
+        const Vector2f lightSource{physics.interpolatePosition(lightId, lightBody.position)};
 
-        for (auto& [shadowId, shadowBody] : shadowView) {
-            if (lightId == shadowId) {
-                continue;
+        // Iterate on each shape group rather than on bodies, so that we don't
+        // have to look up the shape of each body
+        for (auto [shadowId, shadowBody, circle] : circleGroup) {
+            if (lightId != shadowId) {
+                addShadowShape(circle.shadowTerminator(lightSource, interpolate(shadowId, shadowBody)),
+                    lightSource, viewArray, shadowShapes);
             }
-            // Compute the edges of the shadow
-            const std::vector<Vector2f> shadowPoints{shadowBody.shadowTerminator(lightBody.position, _scene, shadowId)};
-            // Compute the shadow geometry from the edges and the light source
-            const auto shadowGeometry = computeShadowGeometry(shadowPoints, lightSource, viewArray);
-            if (shadowGeometry.size() > 2) {
-                // Convert to a sf::ConvexShape
-                shadowShapes.emplace_back(shadowGeometry.size());
-                for(std::size_t i{0}; i < shadowGeometry.size(); ++i) {
-                    Vector2i targetCoord{_renderTarget.mapCoordsToPixel(shadowGeometry[i])};
-                    shadowShapes.back().setPoint(i, static_cast<Vector2f>(targetCoord));
-                }
+        }
+        for (auto [shadowId, shadowBody, polygon] : polygonGroup) {
+            if (lightId != shadowId) {
+                // Bodies that did not change since the interpolation tick are
+                // drawn where they are, so their world vertices can be used
+                const bool atWorldVertices{
+                    polygon.hasWorldVertices(_scene.changeTick<Body>(shadowId))
+                    and not _scene.hasChanged<Body>(shadowId, physics.getInterpolationTick())};
+                addShadowShape(polygon.shadowTerminator(lightSource, interpolate(shadowId, shadowBody),
+                    atWorldVertices), lightSource, viewArray, shadowShapes);
             }
         }
     }
     return shadowShapes;
 }
 
+void LightSystem::addShadowShape(const std::vector<Vector2f>& shadowPoints,
+        const Vector2f& lightSource, const std::array<Vector2f, 4>& view,
+        std::vector<sf::ConvexShape>& shadowShapes) {
+    // Compute the shadow geometry from the edges and the light source
+    const auto shadowGeometry = computeShadowGeometry(shadowPoints, lightSource, view);
+    if (shadowGeometry.size() > 2) {
+        // Convert to a sf::ConvexShape
+        shadowShapes.emplace_back(shadowGeometry.size());
+        for(std::size_t i{0}; i < shadowGeometry.size(); ++i) {
+            Vector2i targetCoord{_renderTarget.mapCoordsToPixel(shadowGeometry[i])};
+            shadowShapes.back().setPoint(i, static_cast<Vector2f>(targetCoord));
+        }
+    }
+}
+
 std::vector<Vector2f> LightSystem::computeShadowGeometry(const std::vector<Vector2f>& shadowVertices, const Vector2f& S, const std::array<Vector2f, 4>& view) {
     // Schematic representation, where S is the light source, and the box is the
     // occluding object. A and B are respectively the leftmost and the rightmost
@@ -1,10 +1,20 @@
+#include <algorithm>
 #include <cmath>
+#include <numeric>
+#include <vector>
 #include <systems/PhysicsSystem.hpp>
 #include <Scene.hpp>
+#include <Settings.hpp>
+#include <Kepler.hpp>
 #include <components/Body.hpp>
+#include <components/components.hpp>
 
-PhysicsSystem::PhysicsSystem(Scene& scene):
-    _scene{scene} {
+PhysicsSystem::PhysicsSystem(Scene& scene, const PhysicsSettings& settings):
+    _scene{scene},
+    _settings{settings},
+    _threadPool{settings.physicsThreads},
+    _historyTick{scene.currentTick()},
+    _timeStep{sf::seconds(1.f / settings.stepsPerSecond)} {
 }
 
 void PhysicsSystem::update(sf::Time dt) {
@@ -17,19 +27,62 @@ void PhysicsSystem::update(sf::Time dt) {
 		return;
 	}
 
+	// At high warp, propagate all the steps at once on the conics if
+	// possible, so that the cost does not depend on the time scale
+	const long long int steps{_currentStep.asMicroseconds() / _timeStep.asMicroseconds()};
+	if (_settings.railsTimeScale > 0 and std::abs(_timeScale) >= _settings.railsTimeScale) {
+		if (propagateOnRails(_timeScale < 0.f ? -steps : steps)) {
+			_currentStep -= _timeStep * steps;
+			if (_timeScale > 0.f) {
+				_snapshots.setMemoryBudget(_settings.rewindMemory);
+				_snapshots.record(_stepCounter, _scene);
+				_replay.clear();
+			}
+			_historyTick = _scene.advanceTick();
+			// Do not interpolate across the whole warp
+			saveRenderState();
+			updateWorldVertices();
+			return;
+		}
+	}
+
+	// Going back in time restores a keyframe and simulates forward from it,
+	// which is cheaper than integrating backwards and also undoes collisions
+	if (_timeScale < 0.f and rewind(_stepCounter - steps)) {
+		_currentStep -= _timeStep * steps;
+		saveRenderState();
+		updateWorldVertices();
+		return;
+	}
+
 	// Update until we get back under _timestep
 	// Usually only one update will be needed
 	while (_currentStep >= _timeStep) {
 		_currentStep -= _timeStep;
+		// Rendering interpolates from the state before the last step
+		if (_currentStep < _timeStep) {
+			saveRenderState();
+		}
+		if (_timeScale > 0.f) {
+			recordHistory();
+		}
 		updateStep(_timeScale < 0.f);
 	}
+	updateWorldVertices();
 }
 
 void PhysicsSystem::updateSteps(int steps) {
 	bool backwards{steps < 0};
-	for (int i{0}; i < std::abs(steps); ++i) {
-		updateStep(backwards);
+	if (not backwards or not rewind(_stepCounter + steps)) {
+		for (int i{0}; i < std::abs(steps); ++i) {
+			if (not backwards) {
+				recordHistory();
+			}
+			updateStep(backwards);
+		}
 	}
+	saveRenderState();
+	updateWorldVertices();
 }
 
 void PhysicsSystem::setTimeScale(float timeScale) {
@@ -44,43 +97,540 @@ sf::Time PhysicsSystem::getElapsedTime() const {
 	return _timeStep * _stepCounter;
 }
 
-Vector2f PhysicsSystem::computeAcceleration(const Vector2f& position, EntityId id) const {
-	Vector2f res{0.f, 0.f};
-	for(auto& [otherId, otherBody] : _scene.view<Body>()) {
-		if (otherId != id) {
-			Vector2f dx{otherBody.position - position};
-			float dist{norm(dx)};
-			res += otherBody.mass * dx / (dist * dist * dist);
+float PhysicsSystem::getInterpolationFactor() const {
+	return _settings.renderInterpolation ? _currentStep / _timeStep : 1.f;
+}
+
+Vector2f PhysicsSystem::interpolatePosition(EntityId id, const Vector2f& position) const {
+	std::size_t index;
+	if (not findRenderState(id, index)) {
+		return position;
+	}
+	const Vector2f previous{_previousPositions[index]};
+	return previous + (position - previous) * getInterpolationFactor();
+}
+
+float PhysicsSystem::interpolateRotation(EntityId id, float rotation) const {
+	std::size_t index;
+	if (not findRenderState(id, index)) {
+		return rotation;
+	}
+	// Rotations wrap around, so interpolate along the shortest arc
+	const float previous{_previousRotations[index]};
+	return previous + std::remainder(rotation - previous, 2.f * pi) * getInterpolationFactor();
+}
+
+std::uint64_t PhysicsSystem::getInterpolationTick() const {
+	return _settings.renderInterpolation ? _interpolationTick : std::numeric_limits<std::uint64_t>::max();
+}
+
+float PhysicsSystem::getGravitationalConstant() const {
+	return _gravitationalConstant;
+}
+
+bool PhysicsSystem::isGravitySource(EntityId id, float mass) const {
+	const float threshold{_settings.gravitySourceMassThreshold};
+	return _scene.hasComponent<GravitySource>(id) or (threshold > 0 and mass >= threshold);
+}
+
+Vector2f PhysicsSystem::computeAcceleration(const Vector2f& position, std::size_t index) const {
+	return computeField(position, _sourceSlots[index]);
+}
+
+Vector2f PhysicsSystem::computeField(const Vector2f& position, std::size_t source) const {
+	Vector2f field{computeExtendedField(position, source)};
+	if (_settings.gravitySolver == GravitySolver::BarnesHut) {
+		field += _tree.field(position, source, _settings.barnesHutTheta);
+	} else {
+		field += gravityField(_gravityKernel, _sourcePositions, _sourceMasses, _sourceSoftenings,
+			position, source);
+	}
+	return field * _gravitationalConstant;
+}
+
+Vector2f PhysicsSystem::computeExtendedField(const Vector2f& position, std::size_t source) const {
+	// The solvers see every source as a point mass, this corrects it for
+	// the polygons
+	Vector2f field{0, 0};
+	for (std::size_t e{0}; e < _extendedSources.size(); ++e) {
+		const std::size_t k{_extendedSources[e]};
+		if (k == source) {
+			continue;
+		}
+		const PolygonBody& polygon{*_extendedShapes[e]};
+		// Barnes-Hut may have merged the point mass in a node, but it opens
+		// the nodes within the near field anyway
+		field += extendedField(polygon.multipole, polygon.componentMultipoles, _extendedRotations[e],
+			_settings.nearFieldRadii * polygon.radius, _sourceMasses[k], _sourceSoftenings[k],
+			position - _sourcePositions[k]);
+	}
+	return field;
+}
+
+void PhysicsSystem::computeAccelerations(const std::vector<Vector2f>& positions,
+		std::vector<Vector2f>& accelerations) {
+	updateSources(positions);
+	// Each body only writes its own acceleration, and the sources are a copy
+	// of the positions, so the result does not depend on the number of
+	// threads.
+	_threadPool.parallelFor(positions.size(), _grain, [&](std::size_t begin, std::size_t end) {
+		for (std::size_t i{begin}; i < end; ++i) {
+			accelerations[i] = computeAcceleration(positions[i], i);
+		}
+	});
+}
+
+void PhysicsSystem::computeAccelerations(const std::vector<std::size_t>& indices,
+		const std::vector<Vector2f>& positions, std::vector<Vector2f>& accelerations) {
+	if (indices.empty()) {
+		return;
+	}
+	updateSources(positions);
+	_threadPool.parallelFor(indices.size(), _grain, [&](std::size_t begin, std::size_t end) {
+		for (std::size_t k{begin}; k < end; ++k) {
+			const std::size_t i{indices[k]};
+			accelerations[i] = computeAcceleration(positions[i], i);
+		}
+	});
+}
+
+void PhysicsSystem::updateSources(const std::vector<Vector2f>& positions) {
+	for (std::size_t k{0}; k < _sourceBodies.size(); ++k) {
+		_sourcePositions[k] = positions[_sourceBodies[k]];
+	}
+	if (_settings.gravitySolver == GravitySolver::BarnesHut) {
+		_tree.build(_sourcePositions, _sourceMasses, _sourceSoftenings);
+	}
+}
+
+void PhysicsSystem::gatherSources() {
+	const ComponentStorage<Body>& bodies{_scene.components<Body>()};
+	const EntityId* entities{_scene.componentEntities<Body>()};
+	const std::size_t n{bodies.size()};
+	_sourcePositions.clear();
+	_sourceMasses.clear();
+	_sourceSoftenings.clear();
+	_sourceBodies.clear();
+	_extendedSources.clear();
+	_extendedShapes.clear();
+	_extendedRotations.clear();
+	_sourceSlots.resize(n);
+	for (std::size_t i{0}; i < n; ++i) {
+		if (isGravitySource(entities[i], bodies.masses[i])) {
+			_sourceSlots[i] = _sourcePositions.size();
+			_sourcePositions.push_back(bodies.positions[i]);
+			_sourceMasses.push_back(bodies.masses[i]);
+			const float softening{_scene.hasComponent<GravitySource>(entities[i])
+				? _scene.getComponent<GravitySource>(entities[i]).softening : 0.f};
+			_sourceSoftenings.push_back(softening * softening);
+			_sourceBodies.push_back(i);
+			if (_settings.nearFieldRadii > 0 and _scene.hasComponent<PolygonBody>(entities[i])) {
+				_extendedSources.push_back(_sourceSlots[i]);
+				_extendedShapes.push_back(&_scene.getComponent<PolygonBody>(entities[i]));
+				_extendedRotations.push_back(bodies.rotations[i]);
+			}
+		} else {
+			_sourceSlots[i] = _notASource;
 		}
 	}
-	return res * _gravitationalConstant;
 }
 
 void PhysicsSystem::updateStep(bool backwards) {
+	const long long int from{_stepCounter};
 	_stepCounter += backwards ? -1 : 1;
 
 	float dt{_timeStep.asSeconds() * (backwards ? -1.f : 1.f)};
-	std::map<EntityId, Vector2f> dv;
-	std::map<EntityId, Vector2f> dx;
-	for(auto& [id, body] : _scene.view<Body>()) {
-		Vector2f vel{body.velocity};
-		Vector2f pos{body.position};
-		Vector2f l1{dt * computeAcceleration(pos, id)};
-		Vector2f k1{dt * vel};
-		Vector2f l2{dt * computeAcceleration(pos + 0.5f * k1, id)};
-		Vector2f k2{dt * (vel + 0.5f * l1)};
-		Vector2f l3{dt * computeAcceleration(pos + 0.5f * k2, id)};
-		Vector2f k3{dt * (vel + 0.5f * l2)};
-		Vector2f l4{dt * computeAcceleration(pos + k3, id)};
-		Vector2f k4{dt * (vel + l3)};
-		dx[id] = (k1 + 2.f * k2 + 2.f *  k3 + k4) / 6.f;
-		dv[id] = (l1 + 2.f * l2 + 2.f *  l3 + l4) / 6.f;
-	}
-
-    for(auto& [id, body] : _scene.view<Body>()) {
-		body.position += dx[id];
-		body.velocity += dv[id];
-		body.rotation += body.angularVelocity * dt;
-        body.rotation = std::remainder(body.rotation, 2.f * pi);
+	// Stream through the arrays of the bodies, rather than going through the
+	// entities
+	ComponentStorage<Body>& bodies{_scene.components<Body>()};
+	const std::size_t n{bodies.size()};
+	gatherSources();
+	if (_settings.blockTimesteps) {
+		updateBlocks(from, _stepCounter, dt);
+	} else {
+		// The block state is stale once the bodies moved without it
+		_blockEntities.clear();
+		if (not _integrator or _integratorType != _settings.integrator) {
+			_integratorType = _settings.integrator;
+			_integrator = createIntegrator(_integratorType);
+		}
+		startEncounters(dt);
+		_integrator->step(bodies.positions, bodies.velocities, dt,
+			[this](const std::vector<Vector2f>& positions, std::vector<Vector2f>& accelerations) {
+				computeAccelerations(positions, accelerations);
+			});
+		finishEncounters(dt);
+	}
+
+	_threadPool.parallelFor(n, _grain, [&](std::size_t begin, std::size_t end) {
+		for (std::size_t i{begin}; i < end; ++i) {
+			bodies.rotations[i] = std::remainder(bodies.rotations[i] + bodies.angularVelocities[i] * dt, 2.f * pi);
+		}
+	});
+	_scene.markAllChanged<Body>();
+	// The bodies changed after this tick are changed outside of the steps
+	_historyTick = _scene.advanceTick();
+}
+
+void PhysicsSystem::startEncounters(float dt) {
+	// Near a point mass, the field changes faster than any fixed step can
+	// follow, so the body moves on its exact two-body conic around the source
+	// instead. Kepler's equation in universal variables is regular at any
+	// distance, and the other sources perturb the body with kicks around the
+	// conic, as in the Wisdom-Holman map. The rest of the scene keeps its
+	// step, whatever the encounter. The integrator still advances these
+	// bodies, but their result is replaced, and they do not attract anything.
+	ComponentStorage<Body>& bodies{_scene.components<Body>()};
+	_encounterBodies.clear();
+	_encounterSources.clear();
+	if (_settings.closeEncounterSteps <= 0) {
+		return;
+	}
+	// The time to orbit by one radian at distance r is sqrt(r^3 / (G m))
+	const float duration{_settings.closeEncounterSteps * std::abs(dt)};
+	const float limit{duration * duration * _gravitationalConstant};
+	for (std::size_t i{0}; i < bodies.size(); ++i) {
+		if (_sourceSlots[i] != _notASource) {
+			continue;
+		}
+		std::size_t primary{_notASource};
+		float strongestField{0};
+		for (std::size_t k{0}; k < _sourcePositions.size(); ++k) {
+			const float r2{norm2(_sourcePositions[k] - bodies.positions[i])};
+			// Only point masses have a conic
+			if (_sourceSoftenings[k] > 0 or r2 * std::sqrt(r2) >= limit * _sourceMasses[k]
+					or std::binary_search(_extendedSources.begin(), _extendedSources.end(), k)) {
+				continue;
+			}
+			const float field{_sourceMasses[k] / r2};
+			if (field > strongestField) {
+				strongestField = field;
+				primary = k;
+			}
+		}
+		if (primary != _notASource) {
+			_encounterBodies.push_back(i);
+			_encounterSources.push_back(primary);
+		}
+	}
+	if (_encounterBodies.empty()) {
+		return;
+	}
+
+	updateSources(bodies.positions);
+	_encounterPositions.resize(_encounterBodies.size());
+	_encounterVelocities.resize(_encounterBodies.size());
+	for (std::size_t e{0}; e < _encounterBodies.size(); ++e) {
+		const std::size_t i{_encounterBodies[e]};
+		const std::size_t k{_encounterSources[e]};
+		const std::size_t p{_sourceBodies[k]};
+		const Vector2f kick{computePerturbation(bodies.positions[i], k) * dt / 2.f};
+		_encounterPositions[e] = Vector2d(bodies.positions[i] - bodies.positions[p]);
+		_encounterVelocities[e] = Vector2d(bodies.velocities[i] - bodies.velocities[p] + kick);
+	}
+}
+
+void PhysicsSystem::finishEncounters(float dt) {
+	if (_encounterBodies.empty()) {
+		return;
+	}
+	ComponentStorage<Body>& bodies{_scene.components<Body>()};
+	updateSources(bodies.positions);
+	for (std::size_t e{0}; e < _encounterBodies.size(); ++e) {
+		const std::size_t i{_encounterBodies[e]};
+		const std::size_t k{_encounterSources[e]};
+		const std::size_t p{_sourceBodies[k]};
+		// The body does not attract its primary
+		const double mu{static_cast<double>(_gravitationalConstant * _sourceMasses[k])};
+		propagateKepler(_encounterPositions[e], _encounterVelocities[e], mu, static_cast<double>(dt));
+		bodies.positions[i] = bodies.positions[p] + Vector2f(_encounterPositions[e]);
+		const Vector2f kick{computePerturbation(bodies.positions[i], k) * dt / 2.f};
+		bodies.velocities[i] = bodies.velocities[p] + Vector2f(_encounterVelocities[e]) + kick;
+	}
+}
+
+Vector2f PhysicsSystem::computePerturbation(const Vector2f& position, std::size_t source) const {
+	return computeField(position, source) - computeField(_sourcePositions[source], source);
+}
+
+void PhysicsSystem::updateBlocks(long long int from, long long int to, float dt) {
+	// Kick-drift-kick leapfrog where each body kicks at the boundaries of its
+	// own block of 2^level base steps, and all bodies drift at each base step.
+	// Blocks of a level are aligned on the step counter, so that a body only
+	// needs new forces when its block ends, with the positions of all the
+	// bodies synchronized.
+	ComponentStorage<Body>& bodies{_scene.components<Body>()};
+	const EntityId* entities{_scene.componentEntities<Body>()};
+	const std::size_t n{bodies.size()};
+	const auto isBoundary = [](long long int step, unsigned level) {
+		return step % (1LL << level) == 0;
+	};
+	const auto blockDuration = [dt](unsigned level) {
+		return dt * static_cast<float>(1u << level);
+	};
+
+	// Bodies that moved in the storage since the last step, by a group
+	// rotation or the removal of another body, take their block state along,
+	// so that the half kick opening their block is still closed at its end.
+	// New bodies start on the smallest block, with the forces at their
+	// current position.
+	_activeBodies.clear();
+	if (not std::equal(entities, entities + n, _blockEntities.begin(), _blockEntities.end())) {
+		for (std::size_t j{0}; j < _blockEntities.size(); ++j) {
+			const std::size_t index{Scene::entityIndex(_blockEntities[j])};
+			if (index >= _blockSlots.size()) {
+				_blockSlots.resize(index + 1);
+			}
+			_blockSlots[index] = j;
+		}
+		std::vector<unsigned> levels(n, 0);
+		std::vector<Vector2f> accelerations(n), previousAccelerations(n);
+		for (std::size_t i{0}; i < n; ++i) {
+			const std::size_t index{Scene::entityIndex(entities[i])};
+			const std::size_t j{index < _blockSlots.size() ? _blockSlots[index] : _blockEntities.size()};
+			if (j < _blockEntities.size() and _blockEntities[j] == entities[i]) {
+				levels[i] = _blockLevels[j];
+				accelerations[i] = _blockAccelerations[j];
+				previousAccelerations[i] = _previousAccelerations[j];
+			} else {
+				_activeBodies.push_back(i);
+			}
+		}
+		_blockEntities.assign(entities, entities + n);
+		_blockLevels = std::move(levels);
+		_blockAccelerations = std::move(accelerations);
+		_previousAccelerations = std::move(previousAccelerations);
+	}
+	computeAccelerations(_activeBodies, bodies.positions, _blockAccelerations);
+
+	_threadPool.parallelFor(n, _grain, [&](std::size_t begin, std::size_t end) {
+		for (std::size_t i{begin}; i < end; ++i) {
+			if (isBoundary(from, _blockLevels[i])) {
+				bodies.velocities[i] += _blockAccelerations[i] * blockDuration(_blockLevels[i]) / 2.f;
+			}
+			bodies.positions[i] += bodies.velocities[i] * dt;
+		}
+	});
+
+	_activeBodies.clear();
+	for (std::size_t i{0}; i < n; ++i) {
+		if (isBoundary(to, _blockLevels[i])) {
+			_activeBodies.push_back(i);
+			_previousAccelerations[i] = _blockAccelerations[i];
+		}
+	}
+	computeAccelerations(_activeBodies, bodies.positions, _blockAccelerations);
+
+	const unsigned maxLevel{std::min(_settings.maxBlockLevel, 30u)};
+	const float accuracy{_settings.blockTimestepAccuracy};
+	_threadPool.parallelFor(_activeBodies.size(), _grain, [&](std::size_t begin, std::size_t end) {
+		for (std::size_t k{begin}; k < end; ++k) {
+			const std::size_t i{_activeBodies[k]};
+			unsigned& level{_blockLevels[i]};
+			const Vector2f acceleration{_blockAccelerations[i]};
+			bodies.velocities[i] += acceleration * blockDuration(level) / 2.f;
+
+			// Aarseth's criterion: the block should be a small fraction of
+			// the time the acceleration takes to change, estimated from the
+			// jerk over the block that ended.
+			const float jerk{norm(acceleration - _previousAccelerations[i]) / std::abs(blockDuration(level))};
+			unsigned target{maxLevel};
+			if (jerk > 0) {
+				const float steps{accuracy * norm(acceleration) / (jerk * std::abs(dt))};
+				target = steps < 1 ? 0 : static_cast<unsigned>(std::min(std::log2(steps), static_cast<float>(maxLevel)));
+			}
+			// The end of a block is a boundary of all the smaller levels, but
+			// only of the next level up if the blocks of that level align.
+			if (target < level) {
+				level = target;
+			} else if (target > level and isBoundary(to, level + 1)) {
+				++level;
+			}
+		}
+	});
+}
+
+bool PhysicsSystem::propagateOnRails(long long int steps) {
+	ComponentStorage<Body>& bodies{_scene.components<Body>()};
+	const EntityId* entities{_scene.componentEntities<Body>()};
+	const std::size_t n{bodies.size()};
+	const double duration{static_cast<double>(_timeStep.asSeconds()) * static_cast<double>(steps)};
+	gatherSources();
+	findPrimaries(bodies.positions, _primaries);
+
+	// Thrust changes the conic during the interval, and a conic going under
+	// the surface of its primary means a contact
+	for (std::size_t i{0}; i < n; ++i) {
+		if (isThrusting(entities[i])) {
+			return false;
+		}
+		const std::size_t primary{_primaries[i]};
+		if (primary != _notASource and _scene.hasComponent<CircleBody>(entities[primary])) {
+			const double mu{static_cast<double>(_gravitationalConstant)
+				* static_cast<double>(bodies.masses[i] + bodies.masses[primary])};
+			const Vector2d position{Vector2d(bodies.positions[i] - bodies.positions[primary])};
+			const Vector2d velocity{Vector2d(bodies.velocities[i] - bodies.velocities[primary])};
+			const double radius{static_cast<double>(_scene.getComponent<CircleBody>(entities[primary]).radius)};
+			if (periapsis(position, velocity, mu) <= radius) {
+				return false;
+			}
+		}
+	}
+
+	// Primaries are heavier than their satellites, so going from the heaviest
+	// body propagates each primary before its satellites. Like patched
+	// conics, this neglects the pull of the satellites on their primary.
+	_railsPositions = bodies.positions;
+	_railsVelocities = bodies.velocities;
+	_railsOrder.resize(n);
+	std::iota(_railsOrder.begin(), _railsOrder.end(), std::size_t{0});
+	std::stable_sort(_railsOrder.begin(), _railsOrder.end(), [&](std::size_t a, std::size_t b) {
+		return bodies.masses[a] > bodies.masses[b];
+	});
+	for (std::size_t i : _railsOrder) {
+		const std::size_t primary{_primaries[i]};
+		if (primary == _notASource) {
+			bodies.positions[i] += bodies.velocities[i] * static_cast<float>(duration);
+			continue;
+		}
+		const double mu{static_cast<double>(_gravitationalConstant)
+			* static_cast<double>(bodies.masses[i] + bodies.masses[primary])};
+		Vector2d position{Vector2d(_railsPositions[i] - _railsPositions[primary])};
+		Vector2d velocity{Vector2d(_railsVelocities[i] - _railsVelocities[primary])};
+		propagateKepler(position, velocity, mu, duration);
+		bodies.positions[i] = bodies.positions[primary] + Vector2f(position);
+		bodies.velocities[i] = bodies.velocities[primary] + Vector2f(velocity);
+	}
+
+	// Changing primary during the interval means that the conic was wrong for
+	// a part of it
+	findPrimaries(bodies.positions, _newPrimaries);
+	if (_newPrimaries != _primaries) {
+		bodies.positions = _railsPositions;
+		bodies.velocities = _railsVelocities;
+		return false;
+	}
+
+	const float durationSeconds{static_cast<float>(duration)};
+	for (std::size_t i{0}; i < n; ++i) {
+		bodies.rotations[i] = std::remainder(bodies.rotations[i] + bodies.angularVelocities[i] * durationSeconds, 2.f * pi);
+	}
+	_stepCounter += steps;
+	// The block state is stale once the bodies moved without it
+	_blockEntities.clear();
+	_scene.markAllChanged<Body>();
+	return true;
+}
+
+void PhysicsSystem::findPrimaries(const std::vector<Vector2f>& positions,
+		std::vector<std::size_t>& primaries) const {
+	const std::vector<float>& masses{_scene.components<Body>().masses};
+	primaries.resize(positions.size());
+	for (std::size_t i{0}; i < positions.size(); ++i) {
+		primaries[i] = _notASource;
+		float strongestField{0};
+		for (std::size_t k{0}; k < _sourceBodies.size(); ++k) {
+			const std::size_t j{_sourceBodies[k]};
+			if (masses[j] <= masses[i]) {
+				continue;
+			}
+			const float field{masses[j] / norm2(positions[j] - positions[i])};
+			if (field > strongestField) {
+				strongestField = field;
+				primaries[i] = j;
+			}
+		}
+	}
+}
+
+bool PhysicsSystem::isThrusting(EntityId id) const {
+	if (not _scene.hasComponent<Player>(id)) {
+		return false;
+	}
+	const Player& player{_scene.getComponent<Player>(id)};
+	for (const Player::Controls& controls : {player.playerControls, player.autoControls}) {
+		if (controls.engine or controls.rcsUp or controls.rcsDown or controls.rcsLeft
+				or controls.rcsRight) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void PhysicsSystem::saveRenderState() {
+	const ComponentStorage<Body>& bodies{_scene.components<Body>()};
+	const EntityId* entities{_scene.componentEntities<Body>()};
+	_previousPositions = bodies.positions;
+	_previousRotations = bodies.rotations;
+	_previousEntities.assign(entities, entities + bodies.size());
+	for (std::size_t i{0}; i < bodies.size(); ++i) {
+		const std::size_t entityIndex{Scene::entityIndex(entities[i])};
+		if (entityIndex >= _previousSlots.size()) {
+			_previousSlots.resize(entityIndex + 1);
+		}
+		_previousSlots[entityIndex] = i;
+	}
+	// The next step marks the bodies changed in the current tick
+	_interpolationTick = _scene.currentTick() - 1;
+}
+
+void PhysicsSystem::updateWorldVertices() {
+	for (auto [id, body, polygon] : _scene.group<Body, PolygonBody>()) {
+		polygon.updateWorldVertices(body, _scene.changeTick<Body>(id));
+	}
+}
+
+bool PhysicsSystem::findRenderState(EntityId id, std::size_t& index) const {
+	// By entity rather than by slot, since bodies may move in the storage
+	// between two steps
+	const std::size_t entityIndex{Scene::entityIndex(id)};
+	if (entityIndex >= _previousSlots.size()) {
+		return false;
+	}
+	index = _previousSlots[entityIndex];
+	return index < _previousEntities.size() and _previousEntities[index] == id;
+}
+
+void PhysicsSystem::recordHistory() {
+	const long long int interval{static_cast<long long int>(_settings.keyframeInterval)};
+	if (interval > 0 and _stepCounter % interval == 0) {
+		_snapshots.setMemoryBudget(_settings.rewindMemory);
+		_snapshots.record(_stepCounter, _scene);
+	}
+	// Thrust and collisions since the last step, to replay them
+	_snapshots.recordChanges(_stepCounter, _scene, _historyTick);
+	// The history after this step is being rewritten
+	_replay.clear();
+}
+
+bool PhysicsSystem::rewind(long long int step) {
+	// Within the interval simulated forward by a previous rewind, the state
+	// of each step is still there
+	long long int restoredStep;
+	if (_replay.contains(step)) {
+		_replay.restore(step, _scene, restoredStep);
+		_stepCounter = step;
+		_historyTick = _scene.advanceTick();
+		return true;
+	}
+	if (not _snapshots.restore(step, _scene, restoredStep)) {
+		return false;
+	}
+	_stepCounter = restoredStep;
+	// The block state is stale once the bodies moved without it
+	_blockEntities.clear();
+	// Simulate forward once, with the recorded thrust and collisions, and
+	// keep each step for the next frames of the rewind
+	const std::size_t bodies{_scene.components<Body>().size()};
+	_replay.clear();
+	_replay.setMemoryBudget(static_cast<std::size_t>(step - restoredStep + 1)
+		* SnapshotBuffer::keyframeSize(bodies));
+	_replay.record(_stepCounter, _scene);
+	while (_stepCounter < step) {
+		_snapshots.replayChanges(_stepCounter, _scene);
+		updateStep(false);
+		_replay.record(_stepCounter, _scene);
 	}
+	_historyTick = _scene.advanceTick();
+	return true;
 }
@@ -1,6 +1,8 @@
+#include <algorithm>
 #include <SFML/System/Time.hpp>
 #include <SFML/Graphics/RenderTarget.hpp>
 #include <systems/RenderSystem.hpp>
+#include <systems/PhysicsSystem.hpp>
 #include <components/components.hpp>
 #include <components/Body.hpp>
 #include <components/Temperature.hpp>
@@ -12,43 +14,56 @@ RenderSystem::RenderSystem(Scene& scene):
 }
 
 void RenderSystem::draw(sf::RenderTarget& target, sf::RenderStates states) const {
-    for (auto& [id, sprite] : _scene.view<Sprite>()) {
+    for (auto [id, sprite] : _scene.view<Sprite>()) {
         target.draw(sprite.sprite, states);
     }
-    for (auto& [id, animations] : _scene.view<Animations>()) {
+    for (auto [id, animations] : _scene.view<Animations>()) {
         for (auto& [action, animationData] : animations) {
             if (not animationData.animation.isStopped()) {
                 target.draw(animationData.animation.getSprite(), states);
             }
         }
     }
-    for (auto& [id, temperature] : _scene.view<CircleTemperature>()) {
+    for (auto [id, temperature] : _scene.view<CircleTemperature>()) {
         target.draw(temperature.graphics, states);
     }
-    for (auto& [id, temperature] : _scene.view<PolygonTemperature>()) {
+    for (auto [id, temperature] : _scene.view<PolygonTemperature>()) {
         target.draw(temperature.graphics, states);
     }
 }
 
-void RenderSystem::update() {
-    for (auto& [id, body, sprite] : _scene.view<Body, Sprite>()) {
-        sprite.sprite.setPosition(body.position);
-        sprite.sprite.setRotation(radToDeg(body.rotation));
+void RenderSystem::update(const PhysicsSystem& physics) {
+    // Only update the graphics of the entities that changed since the last
+    // update. The bodies moved by the last physics step are interpolated, so
+    // they move at each frame until the next step.
+    const std::uint64_t since{_lastTick};
+    const std::uint64_t bodiesSince{std::min(since, physics.getInterpolationTick())};
+    _lastTick = _scene.advanceTick();
+
+    for (auto [id, body, sprite] : _scene.changed<Body, Sprite>(bodiesSince)) {
+        sprite.sprite.setPosition(physics.interpolatePosition(id, body.position));
+        sprite.sprite.setRotation(radToDeg(physics.interpolateRotation(id, body.rotation)));
     }
-    for (auto& [id, body, temperature] : _scene.view<Body, CircleTemperature>()) {
+    for (auto [id, temperature] : _scene.changed<CircleTemperature>(since)) {
         temperature.graphics.update(temperature.field, _table);
-        temperature.graphics.setPosition(body.position);
-        temperature.graphics.setRotation(radToDeg(body.rotation));
     }
-    for (auto& [id, body, temperature] : _scene.view<Body, PolygonTemperature>()) {
+    for (auto [id, body, temperature] : _scene.changed<Body, CircleTemperature>(bodiesSince)) {
+        temperature.graphics.setPosition(physics.interpolatePosition(id, body.position));
+        temperature.graphics.setRotation(radToDeg(physics.interpolateRotation(id, body.rotation)));
+    }
+    for (auto [id, temperature] : _scene.changed<PolygonTemperature>(since)) {
         temperature.graphics.update(temperature.field, _table);
-        temperature.graphics.setPosition(body.position);
-        temperature.graphics.setRotation(radToDeg(body.rotation));
     }
-    for (auto& [id, body, animations] : _scene.view<Body, Animations>()) {
+    for (auto [id, body, temperature] : _scene.changed<Body, PolygonTemperature>(bodiesSince)) {
+        temperature.graphics.setPosition(physics.interpolatePosition(id, body.position));
+        temperature.graphics.setRotation(radToDeg(physics.interpolateRotation(id, body.rotation)));
+    }
+    for (auto [id, body, animations] : _scene.changed<Body, Animations>(bodiesSince)) {
+        const Vector2f position{physics.interpolatePosition(id, body.position)};
+        const float rotation{physics.interpolateRotation(id, body.rotation)};
         for (auto& [action, animationData] : animations) {
-            animationData.animation.getSprite().setPosition(body.position);
-            animationData.animation.getSprite().setRotation(radToDeg(body.rotation));
+            animationData.animation.getSprite().setPosition(position);
+            animationData.animation.getSprite().setRotation(radToDeg(rotation));
         }
     }
 }
@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <cmath>
 #include <cstddef>
 #include <SFML/System/Time.hpp>
 #include <systems/ThermodynamicsSystem.hpp>
@@ -15,11 +17,12 @@ ThermodynamicsSystem::ThermodynamicsSystem(Scene& scene):
 void ThermodynamicsSystem::update(sf::Time timeStep) {
     float dt{timeStep.asSeconds() * 1e3f};
 
-    for (auto& [id, body, temperature, polygonTemperature] :
+    for (auto [id, body, temperature, polygonTemperature] :
             _scene.view<Body, Temperature, PolygonTemperature>()) {
         const GridField<float> field{polygonTemperature.field};
         Vector2s gridSize{field.getGridSize()};
         Vector2f cellSize{field.getCellSize()};
+        float maxChange{0};
 
         for (std::size_t row{0}; row < gridSize.x; ++row) {
             for (std::size_t col{0}; col < gridSize.y; ++col) {
@@ -31,15 +34,18 @@ void ThermodynamicsSystem::update(sf::Time timeStep) {
                 const float T_ym{field.at(row, col == 0 ? 1 : col - 1)};
                 const float T_yp{field.at(row, col == gridSize.y - 1 ? col - 1 : col + 1)};
 
-                polygonTemperature.field.at(row, col) = T + dt * temperature.diffusivity * (
+                const float deltaT{dt * temperature.diffusivity * (
                     (T_xm + T_xp - 2 * T) / (cellSize.x * cellSize.x) +
                     (T_ym + T_yp - 2 * T) / (cellSize.y * cellSize.y)
-                );
+                )};
+                polygonTemperature.field.at(row, col) = T + deltaT;
+                maxChange = std::max(maxChange, std::abs(deltaT));
             }
         }
+        markChanged(id, polygonTemperature, maxChange);
     }
 
-    for (auto& [id, body, temperature, circleTemperature] :
+    for (auto [id, body, temperature, circleTemperature] :
             _scene.view<Body, Temperature, CircleTemperature>()) {
         const PolarField<float> field{circleTemperature.field};
         const float rhoStep{field.getRho(1)};
@@ -47,6 +53,7 @@ void ThermodynamicsSystem::update(sf::Time timeStep) {
         const std::size_t rhoSteps{field.getRhoSteps()};
         const std::size_t thetaSteps{field.getThetaSteps()};
         float totalDeltaT{0};
+        float maxChange{0};
 
         for (std::size_t theta_i{0}; theta_i < thetaSteps; ++theta_i) {
             for (std::size_t rho_i{1}; rho_i < rhoSteps; ++rho_i) {
@@ -65,8 +72,22 @@ void ThermodynamicsSystem::update(sf::Time timeStep) {
                 )};
                 circleTemperature.field.at(rho_i, theta_i) += deltaT;
                 totalDeltaT -= deltaT;
+                maxChange = std::max(maxChange, std::abs(deltaT));
             }
         }
         circleTemperature.field.at(0, 0) += totalDeltaT;
+        maxChange = std::max(maxChange, std::abs(totalDeltaT));
+        markChanged(id, circleTemperature, maxChange);
+    }
+}
+
+template <typename T>
+void ThermodynamicsSystem::markChanged(EntityId id, T& temperature, float maxChange) {
+    // The changes of each update add up, so that a slow drift is still
+    // shown once it is large enough
+    temperature.unmarkedChange += maxChange;
+    if (temperature.unmarkedChange > changeThreshold) {
+        _scene.markChanged<T>(id);
+        temperature.unmarkedChange = 0;
     }
 }
@@ -0,0 +1,117 @@
+#include <cmath>
+#include <random>
+#include <algorithm>
+#include <vector>
+#include <BarnesHutTree.hpp>
+#include <catch.hpp>
+
+using namespace Catch::literals;
+
+namespace {
+    Vector2f directSum(const std::vector<Vector2f>& positions, const std::vector<float>& masses,
+            const std::vector<float>& softenings, std::size_t index) {
+        Vector2f res{0, 0};
+        for (std::size_t j{0}; j < positions.size(); ++j) {
+            if (j != index) {
+                const Vector2f dx{positions[j] - positions[index]};
+                const float dist{std::sqrt(norm2(dx) + softenings[j])};
+                res += masses[j] * dx / (dist * dist * dist);
+            }
+        }
+        return res;
+    }
+}
+
+TEST_CASE("Barnes-Hut tree", "[barnesHut]") {
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<float> positionDistribution(-1000.f, 1000.f);
+    std::uniform_real_distribution<float> massDistribution(1.f, 100.f);
+    std::vector<Vector2f> positions;
+    std::vector<float> masses;
+    for (int i{0}; i < 500; ++i) {
+        positions.emplace_back(positionDistribution(generator), positionDistribution(generator));
+        masses.push_back(massDistribution(generator));
+    }
+    std::vector<float> softenings(positions.size(), 0.f);
+    BarnesHutTree tree;
+    tree.build(positions, masses, softenings);
+
+    SECTION("theta = 0 is the direct sum") {
+        for (std::size_t i{0}; i < positions.size(); i += 7) {
+            const Vector2f expected{directSum(positions, masses, softenings, i)};
+            const Vector2f actual{tree.field(positions[i], i, 0.f)};
+            REQUIRE(actual.x == Approx(expected.x).epsilon(1e-3));
+            REQUIRE(actual.y == Approx(expected.y).epsilon(1e-3));
+        }
+    }
+
+    SECTION("softening") {
+        std::uniform_real_distribution<float> softeningDistribution(0.f, 100.f);
+        for (float& softening : softenings) {
+            const float length{softeningDistribution(generator)};
+            softening = length * length;
+        }
+        tree.build(positions, masses, softenings);
+        for (std::size_t i{0}; i < positions.size(); i += 7) {
+            const Vector2f expected{directSum(positions, masses, softenings, i)};
+            const Vector2f actual{tree.field(positions[i], i, 0.f)};
+            REQUIRE(actual.x == Approx(expected.x).epsilon(1e-3));
+            REQUIRE(actual.y == Approx(expected.y).epsilon(1e-3));
+        }
+        // The field vanishes at the center of a lone softened body, instead
+        // of diverging
+        tree.build({{0.f, 0.f}}, {10.f}, {4.f});
+        REQUIRE(norm(tree.field({0.f, 0.f}, 1, 0.5f)) == 0_a);
+        REQUIRE(tree.field({2.f, 0.f}, 1, 0.5f).x == Approx(-10.f * 2.f / std::pow(8.f, 1.5f)));
+    }
+
+    SECTION("approximation") {
+        // The relative error can be large where the field mostly cancels out,
+        // so the error is compared to the mean field
+        std::vector<float> errors;
+        float meanField{0};
+        float meanRelativeError{0};
+        for (std::size_t i{0}; i < positions.size(); ++i) {
+            const Vector2f expected{directSum(positions, masses, softenings, i)};
+            const Vector2f actual{tree.field(positions[i], i, 0.5f)};
+            errors.push_back(norm(actual - expected));
+            meanField += norm(expected);
+            meanRelativeError += errors.back() / norm(expected);
+        }
+        meanField /= static_cast<float>(positions.size());
+        meanRelativeError /= static_cast<float>(positions.size());
+        REQUIRE(*std::max_element(errors.begin(), errors.end()) < 0.05f * meanField);
+        REQUIRE(meanRelativeError < 0.02f);
+    }
+
+    SECTION("rebuild") {
+        positions.resize(2);
+        masses.resize(2);
+        softenings.resize(2);
+        tree.build(positions, masses, softenings);
+        const Vector2f expected{directSum(positions, masses, softenings, 0)};
+        const Vector2f actual{tree.field(positions[0], 0, 0.5f)};
+        REQUIRE(actual.x == Approx(expected.x));
+        REQUIRE(actual.y == Approx(expected.y));
+    }
+
+    SECTION("coincident bodies") {
+        positions.assign(3, {5.f, 5.f});
+        positions.push_back({10.f, 5.f});
+        masses.assign(4, 1.f);
+        softenings.assign(4, 0.f);
+        tree.build(positions, masses, softenings);
+        // The three coincident bodies are merged, and the excluded one is
+        // removed from their leaf
+        const Vector2f field{tree.field(positions[3], 3, 0.5f)};
+        REQUIRE(field.x == Approx(-3.f / 25.f));
+        REQUIRE(field.y == 0_a);
+    }
+
+    SECTION("single body") {
+        tree.build({{1.f, 2.f}}, {10.f}, {0.f});
+        const Vector2f field{tree.field({1.f, 2.f}, 0, 0.5f)};
+        REQUIRE(field.x == 0_a);
+        REQUIRE(field.y == 0_a);
+    }
+}
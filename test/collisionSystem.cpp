@@ -0,0 +1,118 @@
+#include <vector>
+#include <Scene.hpp>
+#include <Event.hpp>
+#include <components/Body.hpp>
+#include <systems/CollisionSystem.hpp>
+#include <catch.hpp>
+
+namespace {
+    EntityId createBody(Scene& scene, const Vector2f& position, float rotation) {
+        const EntityId id{scene.createEntity()};
+        Body body{};
+        body.density = 1;
+        body.position = position;
+        body.rotation = rotation;
+        body.restitution = 0.5f;
+        body.friction = 0.5f;
+        scene.assignComponent<Body>(id, body);
+        return id;
+    }
+
+    EntityId createPolygon(Scene& scene, const Vector2f& position, float rotation,
+            const std::vector<Vector2f>& vertices) {
+        const EntityId id{createBody(scene, position, rotation)};
+        PolygonBody& polygon{scene.assignComponent<PolygonBody>(id)};
+        polygon = PolygonBody(scene.getComponent<Body>(id), vertices);
+        return id;
+    }
+
+    EntityId createCircle(Scene& scene, const Vector2f& position, float radius) {
+        const EntityId id{createBody(scene, position, 0)};
+        CircleBody& circle{scene.assignComponent<CircleBody>(id)};
+        circle = CircleBody(scene.getComponent<Body>(id), radius);
+        return id;
+    }
+
+    // Puts the bodies at the given positions, at rest
+    void placeBodies(Scene& scene, const std::vector<Vector2f>& positions) {
+        ComponentStorage<Body>& storage{scene.components<Body>()};
+        storage.positions = positions;
+        std::fill(storage.velocities.begin(), storage.velocities.end(), Vector2f(0, 0));
+        std::fill(storage.angularVelocities.begin(), storage.angularVelocities.end(), 0.f);
+        scene.markAllChanged<Body>();
+    }
+}
+
+TEST_CASE("Collision system", "[collisionSystem]") {
+    Scene scene;
+    scene.registerComponent<Body>();
+    scene.registerComponent<CircleBody>();
+    scene.registerComponent<PolygonBody>();
+    scene.registerGroup<Body, CircleBody>();
+    scene.registerGroup<Body, PolygonBody>();
+    const std::vector<Vector2f> box{{0, 0}, {20, 0}, {20, 20}, {0, 20}};
+    const std::vector<Vector2f> hexagon{{0, 10}, {6, 0}, {16, 0}, {22, 10}, {16, 20}, {6, 20}};
+    // A box overlapping a hexagon, and a circle overlapping the box only
+    createPolygon(scene, {0, 0}, 0, box);
+    const EntityId hexagonId{createPolygon(scene, {19, 3}, 0.3f, hexagon)};
+    const EntityId circleId{createCircle(scene, {-5, 16}, 8)};
+    // Overlapping a bit more in the second frame
+    const std::vector<Vector2f> firstFrame{scene.components<Body>().positions};
+    std::vector<Vector2f> secondFrame{firstFrame};
+    for (Vector2f& position : secondFrame) {
+        position *= 0.9f;
+    }
+
+    SECTION("Warm start finds the same contacts") {
+        // Cold: a new system sees the second frame only
+        placeBodies(scene, secondFrame);
+        CollisionSystem coldSystem{scene};
+        coldSystem.update();
+        REQUIRE(coldSystem.getContactCacheSize() == 2);
+        const ComponentStorage<Body>& storage{scene.components<Body>()};
+        const std::vector<Vector2f> coldPositions{storage.positions};
+        const std::vector<Vector2f> coldVelocities{storage.velocities};
+        const std::vector<float> coldAngularVelocities{storage.angularVelocities};
+
+        // Warm: the system starts from what it found in the first frame
+        CollisionSystem warmSystem{scene};
+        placeBodies(scene, firstFrame);
+        warmSystem.update();
+        REQUIRE(warmSystem.getContactCacheSize() == 2);
+        warmSystem.queueEvents();
+        placeBodies(scene, secondFrame);
+        warmSystem.update();
+
+        // The responses move the bodies along the normal by the distance,
+        // so they are the same only if both found the same normal and
+        // distance
+        for (std::size_t i{0}; i < storage.size(); ++i) {
+            REQUIRE(storage.positions[i].x == Approx(coldPositions[i].x));
+            REQUIRE(storage.positions[i].y == Approx(coldPositions[i].y));
+            REQUIRE(storage.velocities[i].x == Approx(coldVelocities[i].x).margin(1e-5));
+            REQUIRE(storage.velocities[i].y == Approx(coldVelocities[i].y).margin(1e-5));
+            REQUIRE(storage.angularVelocities[i] == Approx(coldAngularVelocities[i]).margin(1e-5));
+        }
+        REQUIRE(warmSystem.queueEvents().size() == coldSystem.queueEvents().size());
+    }
+
+    SECTION("Pairs missing from an update are evicted") {
+        CollisionSystem collisionSystem{scene};
+        placeBodies(scene, firstFrame);
+        collisionSystem.update();
+        REQUIRE(collisionSystem.getContactCacheSize() == 2);
+
+        // The circle goes away from the box
+        std::vector<Vector2f> positions{firstFrame};
+        positions[scene.componentIndex<Body>(circleId)] += Vector2f(0, 1000);
+        placeBodies(scene, positions);
+        collisionSystem.update();
+        REQUIRE(collisionSystem.getContactCacheSize() == 1);
+
+        // Then the hexagon
+        positions[scene.componentIndex<Body>(hexagonId)] += Vector2f(1000, 0);
+        placeBodies(scene, positions);
+        collisionSystem.update();
+        REQUIRE(collisionSystem.getContactCacheSize() == 0);
+    }
+}
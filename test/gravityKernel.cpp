@@ -0,0 +1,58 @@
+#include <cmath>
+#include <random>
+#include <vector>
+#include <GravityKernel.hpp>
+#include <catch.hpp>
+
+namespace {
+    // Reference sum in double precision
+    Vector2d referenceField(const std::vector<Vector2f>& positions, const std::vector<float>& masses,
+            const std::vector<float>& softenings, const Vector2f& position, std::size_t exclude) {
+        Vector2d res{0, 0};
+        for (std::size_t j{0}; j < positions.size(); ++j) {
+            if (j != exclude) {
+                const Vector2d dx{Vector2d(positions[j]) - Vector2d(position)};
+                const double dist{std::sqrt(norm2(dx) + static_cast<double>(softenings[j]))};
+                res += static_cast<double>(masses[j]) * dx / (dist * dist * dist);
+            }
+        }
+        return res;
+    }
+}
+
+TEST_CASE("Gravity kernels", "[gravityKernel]") {
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<float> positionDistribution(-1000.f, 1000.f);
+    std::uniform_real_distribution<float> massDistribution(1.f, 100.f);
+    std::uniform_real_distribution<float> softeningDistribution(0.f, 100.f);
+    const auto kernels{availableGravityKernels()};
+    REQUIRE(kernels.front().first == "scalar");
+    REQUIRE(bestGravityKernel() == kernels.back().second);
+
+    // Sizes around the vector widths, to exercise the remainder loops
+    for (std::size_t n : {0, 1, 7, 8, 9, 16, 17, 100}) {
+        std::vector<Vector2f> positions;
+        std::vector<float> masses;
+        std::vector<float> softenings;
+        for (std::size_t i{0}; i < n; ++i) {
+            positions.emplace_back(positionDistribution(generator), positionDistribution(generator));
+            masses.push_back(massDistribution(generator));
+            // Point masses and softened ones, in all the lanes
+            const float softening{i % 3 == 0 ? softeningDistribution(generator) : 0.f};
+            softenings.push_back(softening * softening);
+        }
+        const Vector2f point{positionDistribution(generator), positionDistribution(generator)};
+
+        for (auto& [name, kernel] : kernels) {
+            CAPTURE(name, n);
+            // Evaluate on a body excluding itself, and on a free point
+            for (std::size_t exclude : {n / 2, n}) {
+                const Vector2f position{exclude < n ? positions[exclude] : point};
+                const Vector2d expected{referenceField(positions, masses, softenings, position, exclude)};
+                const Vector2f actual{gravityField(kernel, positions, masses, softenings, position, exclude)};
+                const double tolerance{1e-5 * static_cast<double>(n) * norm(expected) + 1e-12};
+                CHECK(norm(Vector2d(actual) - expected) <= tolerance);
+            }
+        }
+    }
+}
@@ -0,0 +1,67 @@
+#include <cmath>
+#include <vector>
+#include <Integrator.hpp>
+#include <catch.hpp>
+
+namespace {
+    // A body orbiting a fixed unit mass at the origin, with G = 1
+    void centralField(const std::vector<Vector2f>& positions, std::vector<Vector2f>& accelerations) {
+        for (std::size_t i{0}; i < positions.size(); ++i) {
+            const float dist{norm(positions[i])};
+            accelerations[i] = -positions[i] / (dist * dist * dist);
+        }
+    }
+
+    float energy(const Vector2f& position, const Vector2f& velocity) {
+        return dot(velocity, velocity) / 2.f - 1.f / norm(position);
+    }
+
+    // Relative energy drift after ten orbits of an eccentric orbit
+    float energyDrift(IntegratorType type, int stepsPerOrbit) {
+        const auto integrator{createIntegrator(type)};
+        std::vector<Vector2f> positions{{1.f, 0.f}};
+        std::vector<Vector2f> velocities{{0.f, 1.2f}};
+        const float initialEnergy{energy(positions[0], velocities[0])};
+        // Semi-major axis from the energy, and period from Kepler's law
+        const float period{2.f * pi * std::pow(-1.f / (2.f * initialEnergy), 1.5f)};
+        const float dt{period / static_cast<float>(stepsPerOrbit)};
+        for (int i{0}; i < 10 * stepsPerOrbit; ++i) {
+            integrator->step(positions, velocities, dt, centralField);
+        }
+        return std::abs((energy(positions[0], velocities[0]) - initialEnergy) / initialEnergy);
+    }
+}
+
+TEST_CASE("Integrators", "[integrator]") {
+    SECTION("All integrators conserve the energy of an orbit") {
+        for (IntegratorType type : {IntegratorType::Leapfrog, IntegratorType::Yoshida4,
+                IntegratorType::RungeKutta4}) {
+            CAPTURE(type);
+            CHECK(energyDrift(type, 1000) < 1e-3f);
+        }
+    }
+
+    SECTION("Fourth order integrators are more accurate than leapfrog") {
+        CHECK(energyDrift(IntegratorType::Yoshida4, 200) < energyDrift(IntegratorType::Leapfrog, 200));
+        CHECK(energyDrift(IntegratorType::RungeKutta4, 200) < energyDrift(IntegratorType::Leapfrog, 200));
+    }
+
+    SECTION("Splitting integrators are reversible") {
+        for (IntegratorType type : {IntegratorType::Leapfrog, IntegratorType::Yoshida4}) {
+            CAPTURE(type);
+            const auto integrator{createIntegrator(type)};
+            std::vector<Vector2f> positions{{1.f, 0.f}, {0.f, -2.f}};
+            std::vector<Vector2f> velocities{{0.f, 1.2f}, {0.6f, 0.f}};
+            const std::vector<Vector2f> initialPositions{positions};
+            for (int i{0}; i < 500; ++i) {
+                integrator->step(positions, velocities, 0.01f, centralField);
+            }
+            for (int i{0}; i < 500; ++i) {
+                integrator->step(positions, velocities, -0.01f, centralField);
+            }
+            for (std::size_t i{0}; i < positions.size(); ++i) {
+                CHECK(norm(positions[i] - initialPositions[i]) < 1e-4f);
+            }
+        }
+    }
+}
@@ -0,0 +1,64 @@
+#include <cmath>
+#include <Kepler.hpp>
+#include <catch.hpp>
+
+using namespace Catch::literals;
+
+namespace {
+    // Reference trajectory with many small RK4 steps
+    void integrate(Vector2d& position, Vector2d& velocity, double mu, double dt, int steps) {
+        const auto acceleration = [mu](const Vector2d& x) {
+            const double r{norm(x)};
+            return -mu * x / (r * r * r);
+        };
+        const double h{dt / steps};
+        for (int i{0}; i < steps; ++i) {
+            const Vector2d k1{velocity}, l1{acceleration(position)};
+            const Vector2d k2{velocity + h / 2. * l1}, l2{acceleration(position + h / 2. * k1)};
+            const Vector2d k3{velocity + h / 2. * l2}, l3{acceleration(position + h / 2. * k2)};
+            const Vector2d k4{velocity + h * l3}, l4{acceleration(position + h * k3)};
+            position += h / 6. * (k1 + 2. * k2 + 2. * k3 + k4);
+            velocity += h / 6. * (l1 + 2. * l2 + 2. * l3 + l4);
+        }
+    }
+
+    void checkAgainstIntegration(const Vector2d& position, const Vector2d& velocity, double dt) {
+        Vector2d expectedPosition{position}, expectedVelocity{velocity};
+        integrate(expectedPosition, expectedVelocity, 1., dt, 100000);
+        Vector2d actualPosition{position}, actualVelocity{velocity};
+        propagateKepler(actualPosition, actualVelocity, 1., dt);
+        CHECK(norm(actualPosition - expectedPosition) < 1e-6 * norm(expectedPosition));
+        CHECK(norm(actualVelocity - expectedVelocity) < 1e-6 * norm(expectedVelocity));
+    }
+}
+
+TEST_CASE("Kepler propagation", "[kepler]") {
+    SECTION("Elliptic orbit") {
+        checkAgainstIntegration({1., 0.}, {0., 1.2}, 3.);
+        checkAgainstIntegration({1., 0.}, {0., 1.2}, -3.);
+        checkAgainstIntegration({0., -2.}, {-0.3, 0.1}, 7.);
+    }
+
+    SECTION("Hyperbolic orbit") {
+        checkAgainstIntegration({1., 0.}, {0.5, 1.5}, 10.);
+        checkAgainstIntegration({-3., 1.}, {1.2, 0.}, -5.);
+    }
+
+    SECTION("Whole periods") {
+        // Circular orbit of radius 1, with a period of 2 pi
+        Vector2d position{1., 0.}, velocity{0., 1.};
+        propagateKepler(position, velocity, 1., 1000. * 2. * std::acos(-1.) + std::acos(-1.) / 2.);
+        CHECK(position.x == Approx(0.).margin(1e-9));
+        CHECK(position.y == Approx(1.));
+        CHECK(velocity.x == Approx(-1.));
+        CHECK(velocity.y == Approx(0.).margin(1e-9));
+    }
+
+    SECTION("Periapsis") {
+        CHECK(periapsis({1., 0.}, {0., 1.}, 1.) == Approx(1.));
+        // At periapsis already
+        CHECK(periapsis({2., 0.}, {0., 0.9}, 1.) == Approx(2.));
+        // Radial fall has no periapsis above the primary
+        CHECK(periapsis({2., 0.}, {-0.1, 0.}, 1.) == Approx(0.).margin(1e-12));
+    }
+}
@@ -0,0 +1,93 @@
+#include <vector>
+#include <Multipole.hpp>
+#include <polygon.hpp>
+#include <components/Body.hpp>
+#include <catch.hpp>
+
+using namespace Catch::literals;
+
+namespace {
+    // Field of a uniform rectangle of unit density, cut in many small squares
+    Vector2d rectangleField(const Vector2d& min, const Vector2d& max, const Vector2d& position) {
+        const int n{200};
+        const Vector2d cell{(max.x - min.x) / n, (max.y - min.y) / n};
+        Vector2d res{0, 0};
+        for (int i{0}; i < n; ++i) {
+            for (int j{0}; j < n; ++j) {
+                const Vector2d center{min.x + (i + 0.5) * cell.x, min.y + (j + 0.5) * cell.y};
+                const Vector2d dx{center - position};
+                const double dist{norm(dx)};
+                res += cell.x * cell.y * dx / (dist * dist * dist);
+            }
+        }
+        return res;
+    }
+}
+
+TEST_CASE("Multipoles", "[multipole]") {
+    SECTION("Rectangle") {
+        const ConvexPolygon rectangle{{{0, 0}, {4, 0}, {4, 1}, {0, 1}}};
+        const Multipole multipole{polygonMultipole(rectangle, 1.f)};
+        REQUIRE(multipole.mass == 4_a);
+        REQUIRE(multipole.center.x == 2_a);
+        REQUIRE(multipole.center.y == 0.5_a);
+        REQUIRE(multipole.xy == Approx(0.).margin(1e-6));
+        // Elongated along x
+        REQUIRE(multipole.xx > multipole.yy);
+
+        // The quadrupole makes the field an order of magnitude more accurate
+        // than the point mass, a few sizes away
+        for (const Vector2f& position : {Vector2f(14.f, 0.5f), Vector2f(2.f, -8.f), Vector2f(-7.f, 9.f)}) {
+            const Vector2d expected{rectangleField({0, 0}, {4, 1}, Vector2d(position))};
+            const Vector2f pointMass{multipoleField({multipole.center, multipole.mass}, position)};
+            const Vector2f actual{multipoleField(multipole, position)};
+            const double pointMassError{norm(Vector2d(pointMass) - expected)};
+            const double error{norm(Vector2d(actual) - expected)};
+            CHECK(error < pointMassError / 10.);
+            CHECK(error < 1e-3 * norm(expected));
+        }
+    }
+
+    SECTION("Combination") {
+        // Two halves of the rectangle give the moments of the whole
+        const Multipole whole{polygonMultipole(ConvexPolygon({{0, 0}, {4, 0}, {4, 1}, {0, 1}}), 2.f)};
+        const Multipole combined{combineMultipoles({
+            polygonMultipole(ConvexPolygon({{0, 0}, {1, 0}, {1, 1}, {0, 1}}), 2.f),
+            polygonMultipole(ConvexPolygon({{1, 0}, {4, 0}, {4, 1}, {1, 1}}), 2.f)})};
+        REQUIRE(combined.mass == Approx(whole.mass));
+        REQUIRE(combined.center.x == Approx(whole.center.x));
+        REQUIRE(combined.center.y == Approx(whole.center.y));
+        REQUIRE(combined.xx == Approx(whole.xx));
+        REQUIRE(combined.xy == Approx(whole.xy).margin(1e-5));
+        REQUIRE(combined.yy == Approx(whole.yy));
+    }
+
+    SECTION("Polygon body") {
+        // L shape, decomposed in convex components
+        Body body{};
+        body.density = 1.f;
+        const PolygonBody polygon{body, {{0, 0}, {3, 0}, {3, 1}, {1, 1}, {1, 3}, {0, 3}}};
+        REQUIRE(polygon.componentMultipoles.size() == polygon.components.size());
+        REQUIRE(polygon.multipole.mass == Approx(body.mass));
+        REQUIRE(polygon.multipole.center.x == Approx(0.f).margin(1e-5));
+        REQUIRE(polygon.multipole.center.y == Approx(0.f).margin(1e-5));
+        REQUIRE(polygon.radius == Approx(norm(Vector2f(0, 3) - body.centerOfMass)));
+        // Symmetric about the diagonal
+        REQUIRE(polygon.multipole.xx == Approx(polygon.multipole.yy));
+
+        // Near the body, the components are more accurate than the whole
+        for (const Vector2f& point : {Vector2f(3.f, 3.f), Vector2f(4.f, 0.5f), Vector2f(-2.f, 2.f)}) {
+            const Vector2f position{point - body.centerOfMass};
+            const Vector2d expected{rectangleField({0, 0}, {3, 1}, Vector2d(point))
+                + rectangleField({0, 1}, {1, 3}, Vector2d(point))};
+            Vector2f actual{0, 0};
+            for (const Multipole& multipole : polygon.componentMultipoles) {
+                actual += multipoleField(multipole, position);
+            }
+            const Vector2f whole{multipoleField(polygon.multipole, position)};
+            const double error{norm(Vector2d(actual) - expected)};
+            CHECK(error < norm(Vector2d(whole) - expected));
+            CHECK(error < 0.05 * norm(expected));
+        }
+    }
+}
@@ -0,0 +1,191 @@
+#include <cmath>
+#include <utility>
+#include <vector>
+#include <Scene.hpp>
+#include <Settings.hpp>
+#include <components/Body.hpp>
+#include <components/components.hpp>
+#include <systems/CollisionSystem.hpp>
+#include <systems/PhysicsSystem.hpp>
+#include <catch.hpp>
+
+namespace {
+    void registerComponents(Scene& scene) {
+        scene.registerComponent<Body>();
+        scene.registerComponent<CircleBody>();
+        scene.registerComponent<PolygonBody>();
+        scene.registerComponent<GravitySource>();
+        scene.registerComponent<Player>();
+        scene.registerGroup<Body, CircleBody>();
+        scene.registerGroup<Body, PolygonBody>();
+    }
+
+    EntityId createCircle(Scene& scene, const Vector2f& position, const Vector2f& velocity, float radius) {
+        const EntityId id{scene.createEntity()};
+        Body body{};
+        body.density = 1;
+        body.position = position;
+        body.velocity = velocity;
+        body.restitution = 1;
+        scene.assignComponent<Body>(id, body);
+        CircleBody& circle{scene.assignComponent<CircleBody>(id)};
+        circle = CircleBody(scene.getComponent<Body>(id), radius);
+        return id;
+    }
+
+    EntityId createPointMass(Scene& scene, const Vector2f& position, const Vector2f& velocity, float mass) {
+        const EntityId id{scene.createEntity()};
+        Body body{};
+        body.density = 1;
+        body.mass = mass;
+        body.position = position;
+        body.velocity = velocity;
+        scene.assignComponent<Body>(id, body);
+        return id;
+    }
+}
+
+TEST_CASE("Rewind", "[physicsSystem]") {
+    Scene scene;
+    registerComponents(scene);
+    PhysicsSettings settings;
+    settings.physicsThreads = 1;
+    settings.railsTimeScale = 0;
+    settings.keyframeInterval = 50;
+
+    SECTION("Rewinds across a collision between circles") {
+        // Two circles bouncing off each other around step 30, with no gravity
+        const std::vector<EntityId> ids{
+            createCircle(scene, {0, 0}, {50, 0}, 10),
+            createCircle(scene, {80, 5}, {-20, 0}, 15)};
+        PhysicsSystem physics{scene, settings};
+        CollisionSystem collision{scene};
+        std::vector<std::vector<Body>> history;
+        bool collided{false};
+        for (int i{0}; i < 80; ++i) {
+            history.push_back({scene.getComponent<Body>(ids[0]), scene.getComponent<Body>(ids[1])});
+            collision.update();
+            collided = collided or not collision.queueEvents().empty();
+            physics.updateSteps(1);
+        }
+        REQUIRE(collided);
+        REQUIRE(scene.getComponent<Body>(ids[0]).velocity.x < 0);
+
+        // Step back one step at a time, then jump back to the start
+        for (int i{79}; i >= 40; --i) {
+            physics.updateSteps(-1);
+            REQUIRE(physics.getStepCounter() == i);
+            for (std::size_t j{0}; j < ids.size(); ++j) {
+                const Body body = scene.getComponent<Body>(ids[j]);
+                REQUIRE(body.position.x == Approx(history[i][j].position.x));
+                REQUIRE(body.position.y == Approx(history[i][j].position.y));
+                REQUIRE(body.velocity.x == Approx(history[i][j].velocity.x));
+                REQUIRE(body.velocity.y == Approx(history[i][j].velocity.y));
+            }
+        }
+        physics.updateSteps(-30);
+        REQUIRE(physics.getStepCounter() == 10);
+        for (std::size_t j{0}; j < ids.size(); ++j) {
+            const Body body = scene.getComponent<Body>(ids[j]);
+            REQUIRE(body.position.x == Approx(history[10][j].position.x));
+            REQUIRE(body.velocity.x == Approx(history[10][j].velocity.x));
+        }
+    }
+}
+
+TEST_CASE("Block timesteps", "[physicsSystem]") {
+    PhysicsSettings settings;
+    settings.blockTimesteps = true;
+    settings.physicsThreads = 1;
+    settings.railsTimeScale = 0;
+    settings.keyframeInterval = 0;
+    settings.closeEncounterSteps = 0;
+    const float sunMass{1e14f};
+
+    // A fast body on an eccentric orbit, which changes its block as it
+    // passes the periapsis, and a slow body on a circular orbit, on a long
+    // block. Removing the body before them in the storage moves the slow
+    // body to its slot, with its block still open. Returns the final state
+    // of the fast and slow bodies, and their relative change of energy.
+    const auto run = [&](int removeStep) {
+        Scene scene;
+        registerComponents(scene);
+        const EntityId sun{createPointMass(scene, {0, 0}, {0, 0}, sunMass)};
+        scene.assignComponent<GravitySource>(sun);
+        const EntityId removed{createPointMass(scene, {1e6f, 1e6f}, {0, 0}, 1)};
+        PhysicsSystem physics{scene, settings};
+        const float mu{physics.getGravitationalConstant() * sunMass};
+        const std::vector<EntityId> ids{
+            createPointMass(scene, {1000, 0}, {0, 1.2f * std::sqrt(mu / 1000)}, 1),
+            createPointMass(scene, {-8000, 0}, {0, -std::sqrt(mu / 8000)}, 1)};
+        const auto energy = [&](EntityId id) {
+            const Body body = scene.getComponent<Body>(id);
+            return norm2(body.velocity) / 2 - mu / norm(body.position);
+        };
+        const std::vector<float> energies{energy(ids[0]), energy(ids[1])};
+        for (int i{0}; i < 4000; ++i) {
+            if (i == removeStep) {
+                scene.removeEntity(removed);
+            }
+            physics.updateSteps(1);
+        }
+        std::vector<std::pair<Body, float>> res;
+        for (std::size_t j{0}; j < ids.size(); ++j) {
+            res.emplace_back(scene.getComponent<Body>(ids[j]), energy(ids[j]) / energies[j] - 1);
+        }
+        return res;
+    };
+
+    const auto reference = run(-1);
+    for (int removeStep : {1000, 1300, 1517}) {
+        const auto moved = run(removeStep);
+        for (std::size_t j{0}; j < moved.size(); ++j) {
+            REQUIRE(std::abs(moved[j].second) < 1e-3f);
+            REQUIRE(moved[j].first.position.x == Approx(reference[j].first.position.x).margin(0.1));
+            REQUIRE(moved[j].first.position.y == Approx(reference[j].first.position.y).margin(0.1));
+        }
+    }
+}
+
+TEST_CASE("Render interpolation", "[physicsSystem]") {
+    Scene scene;
+    registerComponents(scene);
+    PhysicsSettings settings;
+    settings.physicsThreads = 1;
+    settings.railsTimeScale = 0;
+    settings.keyframeInterval = 0;
+    const EntityId first{createPointMass(scene, {0, 0}, {0, 0}, 1)};
+    const EntityId second{createPointMass(scene, {100, 0}, {0, 0}, 1)};
+    // Moves by one pixel at each step
+    const EntityId moving{createPointMass(scene, {100, 0}, {50, 0}, 1)};
+    PhysicsSystem physics{scene, settings};
+    // One step, then half of the next one
+    physics.update(sf::seconds(1.f / settings.stepsPerSecond));
+    physics.update(sf::seconds(0.5f / settings.stepsPerSecond));
+    REQUIRE(physics.getInterpolationFactor() == Approx(0.5f));
+    const auto requireInterpolated = [&] {
+        const Body body = scene.getComponent<Body>(moving);
+        REQUIRE(body.position.x == Approx(101));
+        REQUIRE(physics.interpolatePosition(moving, body.position).x == Approx(100.5));
+    };
+    requireInterpolated();
+
+    SECTION("After another body is erased") {
+        // The moving body takes the slot of the erased one
+        scene.removeEntity(first);
+        requireInterpolated();
+        // A new body in the freed slot of the entity index is not interpolated
+        const EntityId created{createPointMass(scene, {-10, 0}, {0, 0}, 1)};
+        REQUIRE(Scene::entityIndex(created) == Scene::entityIndex(first));
+        REQUIRE(physics.interpolatePosition(created, {-10, 0}).x == Approx(-10));
+    }
+
+    SECTION("After the storage is reordered") {
+        // The owning group of circles moves the moving body to the front
+        CircleBody& circle{scene.assignComponent<CircleBody>(moving)};
+        circle = CircleBody(scene.getComponent<Body>(moving), 5);
+        REQUIRE(scene.componentIndex<Body>(moving) == 0);
+        requireInterpolated();
+        REQUIRE(physics.interpolatePosition(second, {100, 0}).x == Approx(100));
+    }
+}
@@ -33,6 +33,17 @@ TEST_CASE("polygon functions", "[polygon]") {
         REQUIRE(box.momentOfInertia(1, {0, 0.5}) == Approx(5./12.));
     }
 
+    SECTION("secondMoments") {
+        const std::array<float, 3> boxMoments{box.secondMoments()};
+        REQUIRE(boxMoments[0] == Approx(1./12.));
+        REQUIRE(boxMoments[1] == Approx(0.).margin(1e-7));
+        REQUIRE(boxMoments[2] == Approx(1./12.));
+        const std::array<float, 3> triangleMoments{triangle.secondMoments()};
+        REQUIRE(triangleMoments[0] == Approx(1./36.));
+        REQUIRE(triangleMoments[1] == Approx(-1./72.));
+        REQUIRE(triangleMoments[2] == Approx(1./36.));
+    }
+
     SECTION("boxContains") {
         const std::array<Vector2f, 4> arrayBox{{{0, 0}, {0, 1}, {1, 1}, {1, 0}}};
         REQUIRE(boxContains(arrayBox, {0.5f, 0.5f}));
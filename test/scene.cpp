@@ -0,0 +1,382 @@
+#include <string>
+#include <algorithm>
+#include <vector>
+#include <Scene.hpp>
+#include <components/Body.hpp>
+#include <catch.hpp>
+
+using namespace Catch::literals;
+
+namespace {
+    struct Position {
+        float x, y;
+    };
+
+    struct Name {
+        std::string name;
+    };
+
+    struct Mass {
+        float mass;
+    };
+
+    // Checks that a group contains exactly the expected entities, with the
+    // right components
+    template <typename... Types>
+    void checkGroup(Scene& scene, std::vector<EntityId> expected) {
+        std::vector<EntityId> actual;
+        for (auto tuple : scene.group<Types...>()) {
+            const EntityId id{std::get<0>(tuple)};
+            actual.push_back(id);
+            REQUIRE(&std::get<1>(tuple) == &scene.getComponent<Position>(id));
+        }
+        std::sort(expected.begin(), expected.end());
+        std::sort(actual.begin(), actual.end());
+        REQUIRE(actual == expected);
+    }
+}
+
+TEST_CASE("scene component storage", "[scene]") {
+    Scene scene;
+    scene.registerComponent<Position>();
+    scene.registerComponent<Name>();
+
+    std::vector<EntityId> ids;
+    for (int i{0}; i < 10; ++i) {
+        const EntityId id{scene.createEntity()};
+        ids.push_back(id);
+        scene.assignComponent<Position>(id, static_cast<float>(i), static_cast<float>(-i));
+        if (i % 2 == 0) {
+            scene.assignComponent<Name>(id, std::to_string(i));
+        }
+    }
+
+    SECTION("assign and get") {
+        for (int i{0}; i < 10; ++i) {
+            REQUIRE(scene.hasComponent<Position>(ids[i]));
+            REQUIRE(scene.getComponent<Position>(ids[i]).x == Approx(i));
+            REQUIRE(scene.hasComponent<Name>(ids[i]) == (i % 2 == 0));
+        }
+    }
+
+    SECTION("erase keeps the other components reachable") {
+        scene.eraseComponent<Position>(ids[3]);
+        scene.eraseComponent<Position>(ids[0]);
+        REQUIRE(not scene.hasComponent<Position>(ids[3]));
+        REQUIRE(not scene.hasComponent<Position>(ids[0]));
+        for (int i : {1, 2, 4, 5, 6, 7, 8, 9}) {
+            REQUIRE(scene.getComponent<Position>(ids[i]).y == Approx(-i));
+        }
+        scene.assignComponent<Position>(ids[3], 30.f, 30.f);
+        REQUIRE(scene.getComponent<Position>(ids[3]).x == 30_a);
+    }
+
+    SECTION("remove entity") {
+        scene.removeEntity(ids[4]);
+        scene.removeEntity(ids[5]);
+        REQUIRE(not scene.hasComponent<Position>(ids[4]));
+        REQUIRE(not scene.hasComponent<Name>(ids[4]));
+        REQUIRE(scene.getComponent<Name>(ids[8]).name == "8");
+        auto view = scene.view<Position, Name>();
+        REQUIRE(std::distance(view.begin(), view.end()) == 4);
+    }
+
+    SECTION("view") {
+        std::size_t count{0};
+        for (auto [id, position, name] : scene.view<Position, Name>()) {
+            REQUIRE(scene.hasComponent<Name>(id));
+            REQUIRE(name.name == std::to_string(static_cast<int>(position.x)));
+            position.y = 1.f;
+            ++count;
+        }
+        REQUIRE(count == 5);
+        REQUIRE(scene.getComponent<Position>(ids[4]).y == 1_a);
+        REQUIRE(scene.getComponent<Position>(ids[5]).y == -5_a);
+    }
+
+    SECTION("findUnique") {
+        for (int i : {2, 4, 6, 8}) {
+            scene.eraseComponent<Name>(ids[i]);
+        }
+        REQUIRE(scene.findUnique<Name>() == ids[0]);
+    }
+
+    SECTION("recycled IDs") {
+        scene.removeEntity(ids[2]);
+        const EntityId recycled{scene.createEntity()};
+        REQUIRE(Scene::entityIndex(recycled) == Scene::entityIndex(ids[2]));
+        REQUIRE(recycled != ids[2]);
+        REQUIRE(not scene.isValid(ids[2]));
+        REQUIRE(scene.isValid(recycled));
+        scene.assignComponent<Position>(recycled, 1.f, 2.f);
+        REQUIRE(scene.hasComponent<Position>(recycled));
+        REQUIRE(not scene.hasComponent<Position>(ids[2]));
+    }
+
+    SECTION("allEntities") {
+        scene.removeEntity(ids[1]);
+        scene.removeEntity(ids[7]);
+        std::vector<EntityId> alive;
+        for (EntityId id : scene.allEntities()) {
+            alive.push_back(id);
+        }
+        REQUIRE(alive.size() == 8);
+        REQUIRE(std::find(alive.begin(), alive.end(), ids[1]) == alive.end());
+        REQUIRE(std::find(alive.begin(), alive.end(), ids[7]) == alive.end());
+    }
+
+    SECTION("entities with large IDs") {
+        for (int i{0}; i < 10000; ++i) {
+            scene.createEntity();
+        }
+        const EntityId id{scene.createEntity()};
+        scene.assignComponent<Name>(id, "far");
+        REQUIRE(scene.hasComponent<Name>(id));
+        REQUIRE(not scene.hasComponent<Position>(id));
+        REQUIRE(scene.getComponent<Name>(id).name == "far");
+    }
+}
+
+TEST_CASE("scene change tracking", "[scene]") {
+    Scene scene;
+    scene.registerComponent<Position>();
+    scene.registerComponent<Name>();
+
+    std::vector<EntityId> ids;
+    for (int i{0}; i < 6; ++i) {
+        const EntityId id{scene.createEntity()};
+        ids.push_back(id);
+        scene.assignComponent<Position>(id, static_cast<float>(i), 0.f);
+        scene.assignComponent<Name>(id, std::to_string(i));
+    }
+    const auto countChanged = [&scene] (std::uint64_t since) {
+        auto view = scene.changed<Position, Name>(since);
+        return std::distance(view.begin(), view.end());
+    };
+
+    // Everything is new
+    REQUIRE(countChanged(0) == 6);
+    const std::uint64_t tick{scene.advanceTick()};
+    REQUIRE(countChanged(tick) == 0);
+
+    SECTION("mark changed") {
+        scene.patchComponent<Position>(ids[1]).x = 10.f;
+        scene.markChanged<Name>(ids[4]);
+        REQUIRE(countChanged(tick) == 2);
+        REQUIRE(scene.hasChanged<Position>(ids[1], tick));
+        REQUIRE(not scene.hasChanged<Name>(ids[1], tick));
+        REQUIRE(scene.changeTick<Position>(ids[1]) == tick + 1);
+        REQUIRE(scene.changeTick<Position>(ids[4]) <= tick);
+        for (auto [id, position, name] : scene.changed<Position, Name>(tick)) {
+            REQUIRE((id == ids[1] or id == ids[4]));
+        }
+        // Changes are not seen after the next tick
+        const std::uint64_t nextTick{scene.advanceTick()};
+        REQUIRE(countChanged(nextTick) == 0);
+        REQUIRE(countChanged(tick) == 2);
+    }
+
+    SECTION("mark all changed") {
+        scene.markAllChanged<Name>();
+        REQUIRE(countChanged(tick) == 6);
+    }
+
+    SECTION("changes follow the components") {
+        scene.markChanged<Position>(ids[0]);
+        scene.removeEntity(ids[2]);
+        scene.eraseComponent<Position>(ids[3]);
+        REQUIRE(countChanged(tick) == 1);
+        REQUIRE(scene.hasChanged<Position>(ids[0], tick));
+        REQUIRE(not scene.hasChanged<Position>(ids[5], tick));
+        const EntityId id{scene.createEntity()};
+        scene.assignComponent<Position>(id, 0.f, 0.f);
+        scene.assignComponent<Name>(id, "new");
+        REQUIRE(countChanged(tick) == 2);
+    }
+}
+
+TEST_CASE("scene command buffer", "[scene]") {
+    Scene scene;
+    scene.registerComponent<Position>();
+    scene.registerComponent<Name>();
+    scene.registerGroup<Position, Name>();
+
+    std::vector<EntityId> ids;
+    for (int i{0}; i < 6; ++i) {
+        const EntityId id{scene.createEntity()};
+        ids.push_back(id);
+        scene.assignComponent<Position>(id, static_cast<float>(i), 0.f);
+        scene.assignComponent<Name>(id, std::to_string(i));
+    }
+    Scene::CommandBuffer& commands{scene.commands()};
+
+    SECTION("changes are deferred") {
+        for (auto [id, position, name] : scene.view<Position, Name>()) {
+            if (position.x > 2.5f) {
+                commands.removeEntity(id);
+            } else {
+                commands.eraseComponent<Name>(id);
+            }
+            const EntityId fragment{commands.createEntity()};
+            commands.assignComponent<Position>(fragment, position.x, 1.f);
+        }
+        REQUIRE(scene.isValid(ids[4]));
+        REQUIRE(scene.hasComponent<Name>(ids[0]));
+        commands.apply();
+        for (int i{0}; i < 6; ++i) {
+            REQUIRE(scene.isValid(ids[i]) == (i < 3));
+        }
+        REQUIRE(not scene.hasComponent<Name>(ids[0]));
+        REQUIRE(scene.hasComponent<Position>(ids[0]));
+        auto positions = scene.view<Position>();
+        REQUIRE(std::distance(positions.begin(), positions.end()) == 9);
+        auto grouped = scene.group<Position, Name>();
+        REQUIRE(grouped.size() == 0);
+    }
+
+    SECTION("commands on removed entities") {
+        commands.removeEntity(ids[1]);
+        commands.removeEntity(ids[1]);
+        commands.eraseComponent<Name>(ids[1]);
+        commands.assignComponent<Position>(ids[1], 0.f, 0.f);
+        commands.assignComponent<Position>(ids[2], 20.f, 0.f);
+        commands.apply();
+        REQUIRE(not scene.isValid(ids[1]));
+        REQUIRE(scene.getComponent<Position>(ids[2]).x == 20_a);
+        checkGroup<Position, Name>(scene, {ids[0], ids[2], ids[3], ids[4], ids[5]});
+    }
+}
+
+TEST_CASE("scene owning groups", "[scene]") {
+    Scene scene;
+    scene.registerComponent<Position>();
+    scene.registerComponent<Name>();
+    scene.registerComponent<Mass>();
+
+    // Entities with a name before the groups are registered
+    std::vector<EntityId> ids;
+    for (int i{0}; i < 10; ++i) {
+        const EntityId id{scene.createEntity()};
+        ids.push_back(id);
+        scene.assignComponent<Position>(id, static_cast<float>(i), static_cast<float>(-i));
+        if (i % 2 == 0) {
+            scene.assignComponent<Name>(id, std::to_string(i));
+        }
+    }
+    scene.registerGroup<Position, Name>();
+    scene.registerGroup<Position, Mass>();
+    // Entities with a mass after the groups are registered
+    for (int i{1}; i < 10; i += 2) {
+        scene.assignComponent<Mass>(ids[i], static_cast<float>(i));
+    }
+
+    SECTION("contents") {
+        checkGroup<Position, Name>(scene, {ids[0], ids[2], ids[4], ids[6], ids[8]});
+        checkGroup<Position, Mass>(scene, {ids[1], ids[3], ids[5], ids[7], ids[9]});
+        for (auto [id, position, mass] : scene.group<Position, Mass>()) {
+            REQUIRE(position.x == Approx(mass.mass));
+        }
+        for (auto [id, position, name] : scene.group<Position, Name>()) {
+            REQUIRE(std::to_string(static_cast<int>(position.x)) == name.name);
+        }
+    }
+
+    SECTION("erase a component") {
+        scene.eraseComponent<Name>(ids[4]);
+        scene.eraseComponent<Position>(ids[3]);
+        checkGroup<Position, Name>(scene, {ids[0], ids[2], ids[6], ids[8]});
+        checkGroup<Position, Mass>(scene, {ids[1], ids[5], ids[7], ids[9]});
+        REQUIRE(scene.getComponent<Position>(ids[4]).x == 4_a);
+        REQUIRE(scene.getComponent<Mass>(ids[3]).mass == 3_a);
+    }
+
+    SECTION("remove entities") {
+        scene.removeEntity(ids[0]);
+        scene.removeEntity(ids[9]);
+        scene.removeEntity(ids[5]);
+        checkGroup<Position, Name>(scene, {ids[2], ids[4], ids[6], ids[8]});
+        checkGroup<Position, Mass>(scene, {ids[1], ids[3], ids[7]});
+        for (auto [id, position, mass] : scene.group<Position, Mass>()) {
+            REQUIRE(position.x == Approx(mass.mass));
+        }
+    }
+
+    SECTION("join the first group") {
+        // Joining the first group rotates the second one in its other array
+        const EntityId id{scene.createEntity()};
+        scene.assignComponent<Name>(id, "10");
+        REQUIRE(scene.assignComponent<Position>(id, 10.f, -10.f).x == 10_a);
+        checkGroup<Position, Name>(scene, {ids[0], ids[2], ids[4], ids[6], ids[8], id});
+        checkGroup<Position, Mass>(scene, {ids[1], ids[3], ids[5], ids[7], ids[9]});
+        for (auto [otherId, position, mass] : scene.group<Position, Mass>()) {
+            REQUIRE(position.x == Approx(mass.mass));
+        }
+        scene.removeEntity(ids[2]);
+        scene.removeEntity(id);
+        checkGroup<Position, Name>(scene, {ids[0], ids[4], ids[6], ids[8]});
+        for (auto [otherId, position, mass] : scene.group<Position, Mass>()) {
+            REQUIRE(position.x == Approx(mass.mass));
+        }
+    }
+
+    SECTION("entities out of any group") {
+        const EntityId id{scene.createEntity()};
+        scene.assignComponent<Position>(id, 10.f, -10.f);
+        checkGroup<Position, Name>(scene, {ids[0], ids[2], ids[4], ids[6], ids[8]});
+        REQUIRE(scene.view<Position>().begin() != scene.view<Position>().end());
+        REQUIRE(scene.getComponent<Position>(id).x == 10_a);
+    }
+}
+
+TEST_CASE("scene structure of arrays storage", "[scene]") {
+    Scene scene;
+    scene.registerComponent<Body>();
+    scene.registerComponent<Name>();
+    scene.registerGroup<Body, Name>();
+
+    std::vector<EntityId> ids;
+    for (int i{0}; i < 6; ++i) {
+        const EntityId id{scene.createEntity()};
+        ids.push_back(id);
+        Body body{};
+        body.position = {static_cast<float>(i), 0.f};
+        body.mass = static_cast<float>(i);
+        scene.assignComponent<Body>(id, body);
+        if (i % 2 == 0) {
+            scene.assignComponent<Name>(id, std::to_string(i));
+        }
+    }
+
+    SECTION("references") {
+        BodyRef body{scene.getComponent<Body>(ids[3])};
+        body.velocity = {1.f, 2.f};
+        body.position.x += 1.f;
+        const Body copy{static_cast<Body>(scene.getComponent<Body>(ids[3]))};
+        REQUIRE(copy.position.x == 4_a);
+        REQUIRE(copy.velocity.y == 2_a);
+        REQUIRE(copy.mass == 3_a);
+    }
+
+    SECTION("streams") {
+        ComponentStorage<Body>& bodies{scene.components<Body>()};
+        const EntityId* entities{scene.componentEntities<Body>()};
+        REQUIRE(bodies.size() == 6);
+        for (std::size_t i{0}; i < bodies.size(); ++i) {
+            REQUIRE(bodies.positions[i].x == Approx(bodies.masses[i]));
+            REQUIRE(scene.getComponent<Body>(entities[i]).mass == Approx(bodies.masses[i]));
+        }
+    }
+
+    SECTION("erase and groups") {
+        scene.removeEntity(ids[0]);
+        scene.eraseComponent<Body>(ids[3]);
+        for (auto [id, body, name] : scene.group<Body, Name>()) {
+            REQUIRE(std::to_string(static_cast<int>(body.position.x)) == name.name);
+        }
+        for (auto [id, body] : scene.view<Body>()) {
+            REQUIRE(body.position.x == Approx(body.mass));
+        }
+        REQUIRE(scene.components<Body>().size() == 4);
+        REQUIRE(scene.getComponent<Body>(ids[5]).mass == 5_a);
+    }
+}
@@ -0,0 +1,173 @@
+#include <vector>
+#include <SnapshotBuffer.hpp>
+#include <Scene.hpp>
+#include <components/Body.hpp>
+#include <catch.hpp>
+
+using namespace Catch::literals;
+
+namespace {
+    // Moves all the bodies by the same amount, to tell the steps apart
+    void step(Scene& scene) {
+        for (auto [id, body] : scene.view<Body>()) {
+            body.position += Vector2f(1.f, 0.f);
+            body.rotation += 0.5f;
+        }
+    }
+}
+
+TEST_CASE("Snapshot buffer", "[snapshotBuffer]") {
+    Scene scene;
+    scene.registerComponent<Body>();
+    std::vector<EntityId> ids;
+    for (int i{0}; i < 4; ++i) {
+        const EntityId id{scene.createEntity()};
+        ids.push_back(id);
+        Body body{};
+        body.position = {0.f, static_cast<float>(i)};
+        scene.assignComponent<Body>(id, body);
+    }
+
+    SnapshotBuffer snapshots;
+    snapshots.setMemoryBudget(1024 * 1024);
+    long long int restoredStep;
+
+    SECTION("Restores the latest keyframe before the step") {
+        REQUIRE_FALSE(snapshots.restore(0, scene, restoredStep));
+        for (long long int i{0}; i < 10; ++i) {
+            if (i % 3 == 0) {
+                snapshots.record(i, scene);
+            }
+            step(scene);
+        }
+        REQUIRE(snapshots.size() == 4);
+        REQUIRE(snapshots.restore(5, scene, restoredStep));
+        REQUIRE(restoredStep == 3);
+        for (std::size_t i{0}; i < ids.size(); ++i) {
+            REQUIRE(scene.getComponent<Body>(ids[i]).position.x == 3_a);
+            REQUIRE(scene.getComponent<Body>(ids[i]).position.y == Approx(static_cast<float>(i)));
+            REQUIRE(scene.getComponent<Body>(ids[i]).rotation == 1.5_a);
+        }
+        REQUIRE_FALSE(snapshots.restore(-1, scene, restoredStep));
+    }
+
+    SECTION("Recording drops the newer keyframes") {
+        for (long long int i{0}; i < 5; ++i) {
+            snapshots.record(i, scene);
+            step(scene);
+        }
+        snapshots.record(2, scene);
+        REQUIRE(snapshots.size() == 3);
+        REQUIRE(snapshots.restore(4, scene, restoredStep));
+        REQUIRE(restoredStep == 2);
+        REQUIRE(scene.getComponent<Body>(ids[0]).position.x == 5_a);
+    }
+
+    SECTION("Restores the bodies when the storage changed") {
+        snapshots.record(0, scene);
+        step(scene);
+        // Reorder the storage and add a body after the keyframe
+        scene.eraseComponent<Body>(ids[0]);
+        const EntityId id{scene.createEntity()};
+        Body body{};
+        body.position = {10.f, 10.f};
+        scene.assignComponent<Body>(id, body);
+        REQUIRE(snapshots.restore(0, scene, restoredStep));
+        for (std::size_t i{1}; i < ids.size(); ++i) {
+            REQUIRE(scene.getComponent<Body>(ids[i]).position.x == 0_a);
+            REQUIRE(scene.getComponent<Body>(ids[i]).position.y == Approx(static_cast<float>(i)));
+        }
+        REQUIRE(scene.getComponent<Body>(id).position.x == 10_a);
+    }
+
+    SECTION("Memory stays under the budget") {
+        snapshots.setMemoryBudget(4096);
+        for (long long int i{0}; i < 1000; ++i) {
+            snapshots.record(i, scene);
+            step(scene);
+        }
+        REQUIRE(snapshots.size() > 0);
+        REQUIRE(snapshots.size() < 1000);
+        REQUIRE(snapshots.memoryUsage() <= 4096);
+        // Only the newest keyframes are kept
+        REQUIRE_FALSE(snapshots.restore(10, scene, restoredStep));
+        REQUIRE(snapshots.restore(999, scene, restoredStep));
+        REQUIRE(restoredStep == 999);
+
+        snapshots.setMemoryBudget(0);
+        snapshots.record(1000, scene);
+        REQUIRE(snapshots.size() == 0);
+    }
+
+    SECTION("Replays the changes made between the steps") {
+        snapshots.record(0, scene);
+        std::uint64_t since{scene.advanceTick()};
+        for (long long int i{0}; i < 4; ++i) {
+            if (i == 2) {
+                // Thrust on a single body
+                scene.patchComponent<Body>(ids[1]).velocity = {0.f, 7.f};
+            }
+            snapshots.recordChanges(i, scene, since);
+            step(scene);
+            since = scene.advanceTick();
+        }
+        REQUIRE(snapshots.restore(3, scene, restoredStep));
+        REQUIRE(restoredStep == 0);
+        snapshots.replayChanges(1, scene);
+        REQUIRE(scene.getComponent<Body>(ids[1]).velocity.y == 0_a);
+        snapshots.replayChanges(2, scene);
+        REQUIRE(scene.getComponent<Body>(ids[1]).velocity.y == 7_a);
+        REQUIRE(scene.getComponent<Body>(ids[1]).position.x == 2_a);
+        REQUIRE(scene.getComponent<Body>(ids[0]).velocity.y == 0_a);
+
+        // Recording again rewrites the history from that step
+        snapshots.recordChanges(2, scene, scene.advanceTick());
+        scene.patchComponent<Body>(ids[1]).velocity = {0.f, 0.f};
+        snapshots.replayChanges(2, scene);
+        REQUIRE(scene.getComponent<Body>(ids[1]).velocity.y == 0_a);
+    }
+
+    SECTION("Changes count in the budget") {
+        const std::size_t budget{3 * SnapshotBuffer::keyframeSize(ids.size())};
+        snapshots.setMemoryBudget(budget);
+        snapshots.record(0, scene);
+        snapshots.record(1, scene);
+        // Every body changes at each step, until the changes take the place
+        // of the oldest keyframe, and then of all of them
+        std::uint64_t since{scene.advanceTick()};
+        long long int i{2};
+        for (; snapshots.size() == 2; ++i) {
+            step(scene);
+            scene.markAllChanged<Body>();
+            snapshots.recordChanges(i, scene, since);
+            since = scene.advanceTick();
+            REQUIRE(snapshots.memoryUsage() <= budget);
+        }
+        REQUIRE(snapshots.size() == 1);
+        REQUIRE_FALSE(snapshots.restore(0, scene, restoredStep));
+        REQUIRE(snapshots.restore(1, scene, restoredStep));
+        for (; snapshots.size() == 1; ++i) {
+            step(scene);
+            scene.markAllChanged<Body>();
+            snapshots.recordChanges(i, scene, since);
+            since = scene.advanceTick();
+            REQUIRE(snapshots.memoryUsage() <= budget);
+        }
+        REQUIRE(snapshots.size() == 0);
+        REQUIRE(snapshots.memoryUsage() <= budget);
+    }
+
+    SECTION("Drops the changes with their keyframes") {
+        snapshots.record(0, scene);
+        snapshots.recordChanges(1, scene, 0);
+        REQUIRE(snapshots.contains(0));
+        REQUIRE_FALSE(snapshots.contains(1));
+        snapshots.clear();
+        REQUIRE(snapshots.size() == 0);
+        REQUIRE_FALSE(snapshots.contains(0));
+        // Nothing to replay without a keyframe
+        scene.patchComponent<Body>(ids[0]).position = {5.f, 5.f};
+        snapshots.replayChanges(1, scene);
+        REQUIRE(scene.getComponent<Body>(ids[0]).position.x == 5_a);
+    }
+}
@@ -0,0 +1,128 @@
+#include <random>
+#include <vector>
+#include <SupportFunctions.hpp>
+#include <polygon.hpp>
+#include <components/Body.hpp>
+#include <catch.hpp>
+
+using namespace Catch::literals;
+
+namespace {
+    // Support point of a component of a body, moving the direction to the
+    // frame of the body and the vertex back to the world
+    Vector2f expectedSupport(const ConvexPolygon& component, const Vector2f& position,
+            float rotation, const Vector2f& centerOfMass, const Vector2f& direction) {
+        return rotate(component.supportFunction(rotate(direction, -rotation)) - centerOfMass, rotation) + position;
+    }
+
+    std::vector<Vector2f> worldVertices(const ConvexPolygon& component, const Vector2f& position,
+            float rotation, const Vector2f& centerOfMass) {
+        std::vector<Vector2f> res;
+        for (const Vector2f& vertex : component.getVertices()) {
+            res.push_back(rotate(vertex - centerOfMass, rotation) + position);
+        }
+        return res;
+    }
+}
+
+TEST_CASE("Support functions", "[supportFunctions]") {
+    const ConvexPolygon triangle{{{0, 0}, {1, 0}, {0, 1}}};
+    const ConvexPolygon box{{{0, 0}, {0, 1}, {1, 1}, {1, 0}}};
+    const ConvexPolygon pentagon{{{0, 0}, {2, 0}, {3, 1}, {1, 2}, {-1, 1}}};
+    const Vector2f position{10, -5};
+    const Vector2f centerOfMass{0.5f, 0.5f};
+    const float rotation{0.8f};
+
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<float> angleDistribution(0.f, 2.f * pi);
+    std::vector<Vector2f> directions;
+    for (int i{0}; i < 50; ++i) {
+        const float angle{angleDistribution(generator)};
+        directions.emplace_back(std::cos(angle), std::sin(angle));
+    }
+
+    SECTION("Point") {
+        const PointSupport point{position};
+        REQUIRE(point({1, 0}) == position);
+        REQUIRE(point({-3, 2}) == position);
+    }
+
+    SECTION("Convex") {
+        for (const ConvexPolygon* component : {&triangle, &box, &pentagon}) {
+            const std::vector<Vector2f> vertices{worldVertices(*component, position, rotation, centerOfMass)};
+            const ConvexSupport support{vertices};
+            for (const Vector2f& direction : directions) {
+                const Vector2f expected{expectedSupport(*component, position, rotation, centerOfMass, direction)};
+                REQUIRE(support(direction).x == Approx(expected.x));
+                REQUIRE(support(direction).y == Approx(expected.y));
+            }
+        }
+    }
+
+    SECTION("Fixed vertex count") {
+        const FixedConvexSupport<3> triangleSupport{worldVertices(triangle, position, rotation, centerOfMass)};
+        const FixedConvexSupport<4> boxSupport{worldVertices(box, position, rotation, centerOfMass)};
+        for (const Vector2f& direction : directions) {
+            const Vector2f expectedTriangle{expectedSupport(triangle, position, rotation, centerOfMass, direction)};
+            REQUIRE(triangleSupport(direction).x == Approx(expectedTriangle.x));
+            REQUIRE(triangleSupport(direction).y == Approx(expectedTriangle.y));
+            const Vector2f expectedBox{expectedSupport(box, position, rotation, centerOfMass, direction)};
+            REQUIRE(boxSupport(direction).x == Approx(expectedBox.x));
+            REQUIRE(boxSupport(direction).y == Approx(expectedBox.y));
+        }
+    }
+
+    SECTION("Dispatch on the vertex count") {
+        for (const ConvexPolygon* component : {&triangle, &box, &pentagon}) {
+            const std::vector<Vector2f> vertices{worldVertices(*component, position, rotation, centerOfMass)};
+            withConvexSupport(vertices, [&](const auto& support) {
+                const Vector2f expected{expectedSupport(*component, position, rotation, centerOfMass, {0, 1})};
+                REQUIRE(support({0, 1}).x == Approx(expected.x));
+                REQUIRE(support({0, 1}).y == Approx(expected.y));
+            });
+        }
+    }
+
+    SECTION("World vertices of a polygon body") {
+        Body body{};
+        body.density = 1;
+        body.position = position;
+        body.rotation = rotation;
+        PolygonBody polygon{body, {{0, 0}, {3, 0}, {3, 1}, {1, 1}, {1, 3}, {0, 3}}};
+        // Compares with the vertices of the body at the given pose
+        const auto requireWorldVertices = [&] (const Vector2f& worldPosition, float worldRotation) {
+            for (std::size_t i{0}; i < polygon.vertices.size(); ++i) {
+                const Vector2f expected{rotate(polygon.vertices[i] - body.centerOfMass, worldRotation) + worldPosition};
+                REQUIRE(polygon.worldVertices[i].x == Approx(expected.x));
+                REQUIRE(polygon.worldVertices[i].y == Approx(expected.y));
+            }
+            for (std::size_t i{0}; i < polygon.components.size(); ++i) {
+                const ConvexPolygon& component{polygon.components[i]};
+                withConvexSupport(polygon.worldComponents[i], [&](const auto& support) {
+                    for (const Vector2f& direction : directions) {
+                        const Vector2f expected{expectedSupport(component, worldPosition,
+                            worldRotation, body.centerOfMass, direction)};
+                        REQUIRE(support(direction).x == Approx(expected.x));
+                        REQUIRE(support(direction).y == Approx(expected.y));
+                    }
+                });
+            }
+        };
+        // The constructor does not know the change tick of the body
+        REQUIRE(not polygon.hasWorldVertices(1));
+        polygon.updateWorldVertices(body, 1);
+        REQUIRE(polygon.hasWorldVertices(1));
+        requireWorldVertices(position, rotation);
+
+        // The vertices follow the change tick, not the pose of the body
+        body.position += Vector2f(4, 2);
+        body.rotation += 1.f;
+        polygon.updateWorldVertices(body, 1);
+        requireWorldVertices(position, rotation);
+        REQUIRE(not polygon.hasWorldVertices(2));
+        polygon.updateWorldVertices(body, 2);
+        REQUIRE(polygon.hasWorldVertices(2));
+        REQUIRE(not polygon.hasWorldVertices(1));
+        requireWorldVertices(body.position, body.rotation);
+    }
+}
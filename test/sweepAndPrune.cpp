@@ -0,0 +1,68 @@
+#include <random>
+#include <utility>
+#include <vector>
+#include <SweepAndPrune.hpp>
+#include <catch.hpp>
+
+namespace {
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> allPairs(const std::vector<SweepAndPrune::Box>& boxes) {
+        std::vector<std::pair<std::uint32_t, std::uint32_t>> res;
+        for (std::uint32_t i{0}; i < boxes.size(); ++i) {
+            for (std::uint32_t j{i + 1}; j < boxes.size(); ++j) {
+                if (boxes[i].min.x <= boxes[j].max.x and boxes[j].min.x <= boxes[i].max.x
+                        and boxes[i].min.y <= boxes[j].max.y and boxes[j].min.y <= boxes[i].max.y) {
+                    res.emplace_back(i, j);
+                }
+            }
+        }
+        return res;
+    }
+}
+
+TEST_CASE("Sweep and prune", "[sweepAndPrune]") {
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<float> positionDistribution(-1000.f, 1000.f);
+    std::uniform_real_distribution<float> sizeDistribution(1.f, 50.f);
+    std::uniform_real_distribution<float> moveDistribution(-5.f, 5.f);
+    std::vector<SweepAndPrune::Box> boxes;
+    for (int i{0}; i < 500; ++i) {
+        const Vector2f min{positionDistribution(generator), positionDistribution(generator)};
+        boxes.push_back({min, min + Vector2f(sizeDistribution(generator), sizeDistribution(generator))});
+    }
+    SweepAndPrune broadPhase;
+
+    SECTION("Same pairs as testing all of them") {
+        broadPhase.update(boxes);
+        REQUIRE(not broadPhase.getPairs().empty());
+        REQUIRE(broadPhase.getPairs() == allPairs(boxes));
+    }
+
+    SECTION("Moving boxes") {
+        broadPhase.update(boxes);
+        for (int t{0}; t < 20; ++t) {
+            for (SweepAndPrune::Box& box : boxes) {
+                const Vector2f move{moveDistribution(generator), moveDistribution(generator)};
+                box.min += move;
+                box.max += move;
+            }
+            broadPhase.update(boxes);
+            REQUIRE(broadPhase.getPairs() == allPairs(boxes));
+        }
+    }
+
+    SECTION("Added and removed boxes") {
+        broadPhase.update(boxes);
+        boxes.erase(boxes.begin() + 100);
+        broadPhase.update(boxes);
+        REQUIRE(broadPhase.getPairs() == allPairs(boxes));
+        boxes.push_back({{0, 0}, {2000, 2000}});
+        broadPhase.update(boxes);
+        REQUIRE(broadPhase.getPairs() == allPairs(boxes));
+    }
+
+    SECTION("Touching boxes") {
+        broadPhase.update({{{0, 0}, {1, 1}}, {{1, 1}, {2, 2}}, {{2.5f, 0}, {3, 1}}});
+        const std::vector<std::pair<std::uint32_t, std::uint32_t>> expected{{0, 1}};
+        REQUIRE(broadPhase.getPairs() == expected);
+    }
+}
@@ -0,0 +1,37 @@
+#include <vector>
+#include <ThreadPool.hpp>
+#include <catch.hpp>
+
+TEST_CASE("Thread pool", "[threadPool]") {
+    // A generator rather than a loop, since Catch enters only one section
+    // per run of the test case
+    const std::size_t threads = GENERATE(as<std::size_t>{}, 1, 2, 3, 8);
+    ThreadPool pool{threads};
+    REQUIRE(pool.size() == threads);
+
+    SECTION("Each index is visited once") {
+        for (std::size_t count : {0, 1, 10, 1000, 12345}) {
+            std::vector<int> visits(count, 0);
+            // Several loops in a row, to reuse the workers
+            for (int loop{0}; loop < 3; ++loop) {
+                // Catch assertions are not thread safe, so only count here
+                pool.parallelFor(count, 16, [&](std::size_t begin, std::size_t end) {
+                    for (std::size_t i{begin}; i < end; ++i) {
+                        ++visits[i];
+                    }
+                });
+            }
+            CAPTURE(threads, count);
+            CHECK(visits == std::vector<int>(count, 3));
+        }
+    }
+
+    SECTION("Small loops run on the calling thread") {
+        const std::thread::id caller{std::this_thread::get_id()};
+        pool.parallelFor(16, 16, [&](std::size_t begin, std::size_t end) {
+            CHECK(begin == 0);
+            CHECK(end == 16);
+            CHECK(std::this_thread::get_id() == caller);
+        });
+    }
+}
@@ -0,0 +1,168 @@
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <Scene.hpp>
+#include <Settings.hpp>
+#include <TrajectoryPredictor.hpp>
+#include <components/Body.hpp>
+#include <components/components.hpp>
+#include <systems/PhysicsSystem.hpp>
+#include <catch.hpp>
+
+namespace {
+    EntityId createBody(Scene& scene, const Vector2f& position, const Vector2f& velocity, float mass) {
+        const EntityId id{scene.createEntity()};
+        Body body{};
+        body.density = 1;
+        body.mass = mass;
+        body.position = position;
+        body.velocity = velocity;
+        scene.assignComponent<Body>(id, body);
+        return id;
+    }
+
+    const std::size_t steps{400};
+
+    void registerComponents(Scene& scene) {
+        scene.registerComponent<Body>();
+        scene.registerComponent<CircleBody>();
+        scene.registerComponent<PolygonBody>();
+        scene.registerComponent<GravitySource>();
+        scene.registerComponent<MapElement>();
+        scene.registerComponent<Player>();
+        scene.registerGroup<Body, CircleBody>();
+        scene.registerGroup<Body, PolygonBody>();
+    }
+
+    // The prediction takes the same steps as the simulation, exact in binary,
+    // and few enough to keep every point
+    PhysicsSettings predictionSettings() {
+        PhysicsSettings settings;
+        settings.stepsPerSecond = 64;
+        settings.integrator = IntegratorType::Leapfrog;
+        settings.physicsThreads = 1;
+        settings.railsTimeScale = 0;
+        settings.closeEncounterSteps = 0;
+        settings.keyframeInterval = 0;
+        settings.predictionTimeStep = 1.f / settings.stepsPerSecond;
+        settings.predictionHorizon = static_cast<float>(steps) * settings.predictionTimeStep;
+        return settings;
+    }
+
+    // Waits for the worker to publish the prediction of the given generation
+    std::shared_ptr<const TrajectoryPredictor::Prediction> waitForPrediction(
+            const TrajectoryPredictor& predictor, std::uint64_t generation) {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        std::shared_ptr<const TrajectoryPredictor::Prediction> prediction{predictor.getPrediction()};
+        while ((not prediction or prediction->generation < generation)
+                and std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            prediction = predictor.getPrediction();
+        }
+        return prediction;
+    }
+
+    // Points of the trajectory of the given entity
+    std::vector<Vector2f> trajectory(const TrajectoryPredictor::Prediction& prediction, EntityId id) {
+        for (std::size_t k{0}; k < prediction.entities.size(); ++k) {
+            if (prediction.entities[k] == id) {
+                return {prediction.points.begin() + static_cast<std::ptrdiff_t>(prediction.offsets[k]),
+                    prediction.points.begin() + static_cast<std::ptrdiff_t>(prediction.offsets[k + 1])};
+            }
+        }
+        return {};
+    }
+}
+
+TEST_CASE("Trajectory predictor", "[trajectoryPredictor]") {
+    Scene scene;
+    registerComponents(scene);
+    const PhysicsSettings settings{predictionSettings()};
+
+    // A heavy sun, a light ship on an eccentric orbit, and a body that is
+    // not on the map
+    const float sunMass{1e14f};
+    const EntityId sun{createBody(scene, {0, 0}, {0, 0}, sunMass)};
+    scene.assignComponent<GravitySource>(sun);
+    PhysicsSystem physics{scene, settings};
+    const float mu{physics.getGravitationalConstant() * sunMass};
+    const EntityId ship{createBody(scene, {1000, 0}, {0, 1.2f * std::sqrt(mu / 1000)}, 1)};
+    scene.assignComponent<MapElement>(ship);
+    const EntityId debris{createBody(scene, {0, 2000}, {0, 0}, 1)};
+    TrajectoryPredictor predictor{settings};
+    REQUIRE(predictor.getPrediction() == nullptr);
+    predictor.update(scene, physics);
+    const std::shared_ptr<const TrajectoryPredictor::Prediction> first{waitForPrediction(predictor, 1)};
+    REQUIRE(first != nullptr);
+    REQUIRE(first->generation == 1);
+    REQUIRE(trajectory(*first, debris).empty());
+    REQUIRE(trajectory(*first, sun).size() == steps + 1);
+    const std::vector<Vector2f> shipTrajectory{trajectory(*first, ship)};
+    REQUIRE(shipTrajectory.size() == steps + 1);
+
+    SECTION("Matches the simulation of point masses") {
+        for (std::size_t s{0}; s <= steps; ++s) {
+            const Vector2f position{scene.getComponent<Body>(ship).position};
+            REQUIRE(shipTrajectory[s].x == Approx(position.x).margin(1));
+            REQUIRE(shipTrajectory[s].y == Approx(position.y).margin(1));
+            physics.updateSteps(1);
+        }
+    }
+
+    SECTION("Predicts again only the invalidated bodies") {
+        // Nothing changed, so nothing is published
+        predictor.update(scene, physics);
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        REQUIRE(predictor.getPrediction() == first);
+
+        // The ship turns around, and the sources are not predicted again
+        scene.getComponent<Body>(ship).velocity *= -1.f;
+        predictor.invalidate(ship);
+        predictor.update(scene, physics);
+        const std::shared_ptr<const TrajectoryPredictor::Prediction> second{waitForPrediction(predictor, 2)};
+        REQUIRE(second->generation == 2);
+        REQUIRE(trajectory(*second, sun) == trajectory(*first, sun));
+        const std::vector<Vector2f> turned{trajectory(*second, ship)};
+        REQUIRE(turned.size() == steps + 1);
+        // Mirrored across the x axis
+        for (std::size_t s{0}; s < turned.size(); ++s) {
+            REQUIRE(turned[s].x == Approx(shipTrajectory[s].x).margin(1));
+            REQUIRE(turned[s].y == Approx(-shipTrajectory[s].y).margin(1));
+        }
+    }
+}
+
+TEST_CASE("Trajectory predictor with a polygon source", "[trajectoryPredictor]") {
+    Scene scene;
+    registerComponents(scene);
+    const PhysicsSettings settings{predictionSettings()};
+    // A long spinning bar, and a ship orbiting close enough that the bar does
+    // not pull as a point mass, which drifts by tens of pixels otherwise. The
+    // integrators differ in the order of their steps, hence the margin.
+    const EntityId bar{scene.createEntity()};
+    Body body{};
+    body.density = 6.25e9f;
+    body.angularVelocity = 0.5f;
+    scene.assignComponent<Body>(bar, body);
+    PolygonBody& polygon{scene.assignComponent<PolygonBody>(bar)};
+    polygon = PolygonBody(scene.getComponent<Body>(bar), {{-200, -20}, {200, -20}, {200, 20}, {-200, 20}});
+    scene.assignComponent<GravitySource>(bar);
+    PhysicsSystem physics{scene, settings};
+    const float mu{physics.getGravitationalConstant() * scene.getComponent<Body>(bar).mass};
+    const EntityId ship{createBody(scene, {0, 500}, {std::sqrt(mu / 500), 0}, 1)};
+    scene.assignComponent<MapElement>(ship);
+    TrajectoryPredictor predictor{settings};
+    predictor.update(scene, physics);
+    const std::shared_ptr<const TrajectoryPredictor::Prediction> prediction{waitForPrediction(predictor, 1)};
+    REQUIRE(prediction != nullptr);
+    const std::vector<Vector2f> shipTrajectory{trajectory(*prediction, ship)};
+    REQUIRE(shipTrajectory.size() == steps + 1);
+    for (std::size_t s{0}; s <= steps; ++s) {
+        const Vector2f position{scene.getComponent<Body>(ship).position};
+        REQUIRE(shipTrajectory[s].x == Approx(position.x).margin(1));
+        REQUIRE(shipTrajectory[s].y == Approx(position.y).margin(1));
+        physics.updateSteps(1);
+    }
+}
@@ -69,6 +69,12 @@ TEMPLATE_TEST_CASE("vector functions", "[vector][template]", float) {
         REQUIRE(rotate<TestType>({10, 0}, pi).y == Approx(0).margin(1));
         REQUIRE(rotate<TestType>({2, 0}, -pi/4).x == Approx(std::sqrt(2.f)));
         REQUIRE(rotate<TestType>({2, 0}, -pi/4).y == Approx(-std::sqrt(2.f)));
+        const Rotation<TestType> rotation{static_cast<TestType>(0.7)};
+        for (const Vector2<TestType>& v : {Vector2<TestType>{1, 0}, Vector2<TestType>{-3, 2}}) {
+            REQUIRE(rotate(v, rotation).x == Approx(rotate(v, static_cast<TestType>(0.7)).x));
+            REQUIRE(rotate(v, rotation).y == Approx(rotate(v, static_cast<TestType>(0.7)).y));
+        }
+        REQUIRE(rotate<TestType>({5, 6}, Rotation<TestType>{}) == Vector2<TestType>{5, 6});
     }
 
     SECTION("intersection") {